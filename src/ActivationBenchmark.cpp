@@ -0,0 +1,165 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "DataReader.hpp"
+#include "NeuralNetwork.hpp"
+#include "NeuralNetworkTrainer.hpp"
+#include "Kernels.hpp"
+
+using namespace air;
+
+/*******************************************************************
+* Exact vs fast sigmoid: error of the fast kernels against libm over
+* a dense grid (fails if it exceeds SIGMOID_FAST_MAX_ERROR), kernel
+* throughput, and speed and accuracy of the whole network on the
+* validation set of a data file.
+*
+* usage: air-bench-activation [data file] [weights.airw]
+* without a weight file a 16-20-3 network is trained for a few epochs
+********************************************************************/
+
+//epochs trained when no weight file is given
+static const int TRAINING_EPOCHS = 50;
+
+//repetitions of every timed run, the fastest one counts
+static const int REPETITIONS = 5;
+
+template<typename F>
+static double fastestRun(F f)
+{
+	double best = 1e300;
+	for (int r = 0; r < REPETITIONS; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+/*******************************************************************
+* Largest error of the fast sigmoid and ns per value of both kernels
+* for every instruction set the CPU supports
+********************************************************************/
+template<typename Real>
+static bool benchmarkKernels(const char* type)
+{
+	const int n = 1 << 20;
+	std::vector<Real> grid(n), x(n), y(n);
+	for (int i = 0; i < n; i++) grid[i] = (Real)(-40 + 80.0 * i / (n - 1));
+
+	//typical activations
+	for (int i = 0; i < n; i++) x[i] = (Real)(16.0 * rand() / RAND_MAX - 8);
+
+	bool withinBound = true;
+	const kernels::Isa isas[] = { kernels::Isa::Scalar, kernels::Isa::SSE2, kernels::Isa::AVX2, kernels::Isa::AVX512 };
+	for (kernels::Isa isa : isas)
+	{
+		if (!kernels::selectIsa(isa)) continue;
+
+		y = grid;
+		kernels::sigmoidFast(y.data(), n);
+
+		double maxError = 0;
+		for (int i = 0; i < n; i++) maxError = std::max(maxError, std::fabs(y[i] - 1 / (1 + std::exp(-(double)grid[i]))));
+		withinBound &= maxError <= kernels::SIGMOID_FAST_MAX_ERROR;
+
+		//the kernels work in place, so the time of refilling the buffer is taken off
+		double copy = fastestRun([&] { y = x; });
+		double exact = fastestRun([&] { y = x; kernels::sigmoid(y.data(), n); }) - copy;
+		double fast = fastestRun([&] { y = x; kernels::sigmoidFast(y.data(), n); }) - copy;
+
+		std::cout << " " << type << " " << kernels::table<Real>().name << ": exact " << exact / n * 1e9 << " ns, fast " << fast / n * 1e9 << " ns per value ("
+			<< exact / fast << "x), max error " << maxError << std::endl;
+	}
+
+	kernels::selectIsa(kernels::detectIsa());
+	return withinBound;
+}
+
+/*******************************************************************
+* Validation set accuracy, MSE and time in both modes
+********************************************************************/
+template<typename Real>
+static void benchmarkNetwork(const char* type, const NeuralNetwork& trained, const DataSubset& set)
+{
+	BasicNeuralNetwork<Real> nn(trained.topology);
+	std::transform(trained.weights.begin(), trained.weights.end(), nn.weights.begin(), [](double w) { return (Real)w; });
+
+	std::vector<BasicNeuronBatch<Real>> scratch(1, BasicNeuronBatch<Real>(nn.topology, EVALUATION_BATCH_SIZE));
+	std::vector<std::vector<Real>> outputs(2, std::vector<Real>(set.size() * nn.nOutput));
+	const char* names[] = { "exact", "fast " };
+
+	for (int m = 0; m < 2; m++)
+	{
+		nn.setActivationMode(m == 0 ? ActivationMode::Exact : ActivationMode::Fast);
+
+		SetStats stats;
+		double batched = fastestRun([&] { stats = nn.evaluateSet(set, scratch); });
+		double single = fastestRun([&]
+		{
+			for (int i = 0; i < set.size(); i++) nn.predict(set.pattern(i), &outputs[m][i * nn.nOutput]);
+		});
+
+		std::cout << " " << type << " " << names[m] << ": accuracy " << stats.accuracy << "%, MSE " << stats.mse << ", batched " << batched / set.size() * 1e9
+			<< " ns, single " << single / set.size() * 1e9 << " ns per pattern" << std::endl;
+	}
+
+	//how far the fast outputs are from the exact ones
+	double maxDifference = 0;
+	int changed = 0;
+	for (int i = 0; i < set.size(); i++)
+	{
+		bool differs = false;
+		for (int k = 0; k < nn.nOutput; k++)
+		{
+			Real exact = outputs[0][i * nn.nOutput + k], fast = outputs[1][i * nn.nOutput + k];
+			maxDifference = std::max(maxDifference, (double)std::fabs(exact - fast));
+			if (nn.clampOutput(exact) != nn.clampOutput(fast)) differs = true;
+		}
+		if (differs) changed++;
+	}
+
+	std::cout << " " << type << " fast vs exact: max output difference " << maxDifference << ", " << changed << " of " << set.size() << " patterns classified differently" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	std::string dataFile = argc > 1 ? argv[1] : "data.csv";
+
+	DataReader reader;
+	if (!reader.loadDataFile(dataFile, 16, 3)) return 1;
+	reader.setCreationApproach(STATIC, 10);
+	std::shared_ptr<TrainingDataSet> set = reader.getTrainingDataSet();
+
+	srand(1);
+	auto nn = std::make_shared<NeuralNetwork>(std::vector<int>{ 16, 20, 3 });
+	if (argc > 2)
+	{
+		if (!nn->loadCheckpoint(argv[2])) return 1;
+	}
+	else
+	{
+		NeuralNetworkTrainer trainer(nn);
+		trainer.setStoppingConditions(TRAINING_EPOCHS, 100);
+		trainer.trainNetwork(set);
+	}
+
+	std::cout << std::endl << "Sigmoid kernels, error bound " << kernels::SIGMOID_FAST_MAX_ERROR << std::endl;
+	bool withinBound = benchmarkKernels<double>("double") & benchmarkKernels<float>("float ");
+
+	std::cout << std::endl << "Validation set, " << set->validationSet.size() << " patterns, " << kernels::table<double>().name << " kernels" << std::endl;
+	benchmarkNetwork<double>("double", *nn, set->validationSet);
+	benchmarkNetwork<float>("float ", *nn, set->validationSet);
+
+	if (!withinBound)
+	{
+		std::cout << std::endl << "Error - Fast sigmoid exceeds its error bound" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "CheckpointWriter.hpp"
+
+using namespace air;
+
+CheckpointWriter::CheckpointWriter() : busy(false), stopping(false)
+{
+	thread = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+	//finish what was submitted before shutting down
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+void CheckpointWriter::submit(const std::function<void()>& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = job;
+	}
+	wake.notify_one();
+}
+
+void CheckpointWriter::flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return !pending && !busy; });
+}
+
+void CheckpointWriter::writerLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		wake.wait(lock, [this] { return stopping || pending; });
+		if (!pending) break;
+
+		std::function<void()> job;
+		job.swap(pending);
+		busy = true;
+
+		//write without holding the lock
+		lock.unlock();
+		job();
+		lock.lock();
+
+		busy = false;
+		if (!pending) idle.notify_all();
+	}
+}
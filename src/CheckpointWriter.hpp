@@ -0,0 +1,37 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace air
+{
+	/*******************************************************************
+	* Background thread that writes checkpoints. Only the latest job is
+	* kept: a job submitted while another one waits replaces it, so the
+	* caller never blocks on disk I/O.
+	********************************************************************/
+	class CheckpointWriter
+	{
+	public:
+		CheckpointWriter();
+		~CheckpointWriter();
+
+		void submit(const std::function<void()>& job);
+
+		//blocks until every submitted job has been written
+		void flush();
+
+	private:
+		void writerLoop();
+
+	private:
+		std::thread thread;
+		std::mutex mutex;
+		std::condition_variable wake;			//signals the writer a job is waiting
+		std::condition_variable idle;			//signals flush the writer has nothing left
+		std::function<void()> pending;
+		bool busy;
+		bool stopping;
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+
+/*******************************************************************
+* In place parsing of csv data lines, shared by the file and stream
+* readers. A line of more than 2 characters holds one entry: comma
+* separated numbers, empty values are skipped (as strtok did) and
+* missing values are left untouched.
+********************************************************************/
+namespace air
+{
+	namespace csv
+	{
+		//end of the line starting at p ('\n' or end of text)
+		inline const char* lineEnd(const char* p, const char* end)
+		{
+			const char* e = static_cast<const char*>(memchr(p, '\n', end - p));
+			return e != nullptr ? e : end;
+		}
+
+		//first line start at or after p
+		inline const char* nextLineStart(const char* begin, const char* p, const char* end)
+		{
+			if (p == begin || p[-1] == '\n') return p;
+			return std::min(lineEnd(p, end) + 1, end);
+		}
+
+		//lines of more than 2 characters (including a '\r') hold an entry
+		inline bool isEntry(const char* line, const char* end)
+		{
+			return end - line > 2;
+		}
+
+		inline int countEntries(const char* begin, const char* end)
+		{
+			int n = 0;
+			for (const char* line = begin; line < end;)
+			{
+				const char* e = lineEnd(line, end);
+				if (isEntry(line, e)) n++;
+				line = e + 1;
+			}
+			return n;
+		}
+
+		//locale independent number parser, like atof blanks and a '+' sign are skipped and anything unreadable is 0
+		inline void parseValue(const char* p, const char* end, double& value)
+		{
+			while (p < end && (*p == ' ' || *p == '\t')) p++;
+			if (p < end && *p == '+') p++;
+			if (std::from_chars(p, end, value).ec != std::errc()) value = 0;
+		}
+
+		//the first nInputs values of a line are the pattern, the next nTargets values the target
+		inline void parseLine(const char* p, const char* end, double* pattern, int nInputs, double* target, int nTargets)
+		{
+			for (int i = 0; i < nInputs + nTargets; i++)
+			{
+				//empty values are skipped
+				while (p < end && *p == ',') p++;
+				if (p == end) break;
+
+				double& value = i < nInputs ? pattern[i] : target[i - nInputs];
+				parseValue(p, end, value);
+
+				//move token onwards
+				p = static_cast<const char*>(memchr(p, ',', end - p));
+				if (p == nullptr) break;
+			}
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#include "DataReader.hpp"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+using namespace air;
+
+/*******************************************************************
+* Converts a csv data file into the binary data file format
+*
+* usage: air-convert <input.csv> <output> <inputs> <targets> [float32]
+********************************************************************/
+int main(int argc, char* argv[])
+{
+	if (argc < 5)
+	{
+		std::cout << "usage: " << argv[0] << " <input.csv> <output> <inputs> <targets> [float32]" << std::endl;
+		return 1;
+	}
+
+	int nInputs = atoi(argv[3]);
+	int nTargets = atoi(argv[4]);
+	if (nInputs <= 0 || nTargets <= 0)
+	{
+		std::cout << "Error - inputs and targets have to be positive" << std::endl;
+		return 1;
+	}
+
+	DataType type = (argc > 5 && std::string(argv[5]) == "float32") ? DataType::Float32 : DataType::Float64;
+
+	DataReader d;
+	return d.convertDataFile(argv[1], argv[2], nInputs, nTargets, type) ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include "DataFile.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+
+using namespace air;
+
+namespace
+{
+	const char DATA_FILE_MAGIC[4] = { 'A', 'I', 'R', 'D' };
+
+	bool littleEndian()
+	{
+		const std::uint16_t one = 1;
+		std::uint8_t first;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	//next multiple of the buffer alignment
+	std::uint64_t aligned(std::uint64_t offset)
+	{
+		return (offset + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+	}
+
+	void writeValues(std::ostream& out, const double* src, std::size_t n, DataType type)
+	{
+		if (type == DataType::Float64) out.write(reinterpret_cast<const char*>(src), n * sizeof(double));
+		else
+		{
+			std::vector<float> f(src, src + n);
+			out.write(reinterpret_cast<const char*>(f.data()), n * sizeof(float));
+		}
+	}
+
+	void pad(std::ostream& out, std::uint64_t offset)
+	{
+		static const char zeros[BUFFER_ALIGNMENT] = {};
+		out.write(zeros, aligned(offset) - offset);
+	}
+}
+
+bool air::isDataFile(const char* begin, std::size_t size)
+{
+	return size >= sizeof(DataFileHeader) && std::memcmp(begin, DATA_FILE_MAGIC, sizeof(DATA_FILE_MAGIC)) == 0;
+}
+
+std::size_t air::dataTypeSize(DataType type)
+{
+	return type == DataType::Float32 ? sizeof(float) : sizeof(double);
+}
+
+void air::readDataValues(const char* src, DataType type, std::size_t n, double* dst)
+{
+	if (type == DataType::Float64) std::memcpy(dst, src, n * sizeof(double));
+	else
+	{
+		for (std::size_t i = 0; i < n; i++)
+		{
+			float f;
+			std::memcpy(&f, src + i * sizeof(float), sizeof(float));
+			dst[i] = f;
+		}
+	}
+}
+
+bool air::checkDataFileHeader(const DataFileHeader& header, std::uint64_t fileSize, int nInputs, int nTargets)
+{
+	if (std::memcmp(header.magic, DATA_FILE_MAGIC, sizeof(DATA_FILE_MAGIC)) != 0 || !littleEndian())
+	{
+		std::cout << "Error - Not a readable data file" << std::endl;
+		return false;
+	}
+	if (header.version != DATA_FILE_VERSION)
+	{
+		std::cout << "Error - Unsupported data file version: " << header.version << std::endl;
+		return false;
+	}
+	if (header.dataType != (std::uint32_t)DataType::Float64 && header.dataType != (std::uint32_t)DataType::Float32)
+	{
+		std::cout << "Error - Unknown data file element type: " << header.dataType << std::endl;
+		return false;
+	}
+	if ((int)header.nInputs != nInputs || (int)header.nTargets != nTargets)
+	{
+		std::cout << "Error - Data file has " << header.nInputs << " inputs and " << header.nTargets << " targets, expected "
+			<< nInputs << " and " << nTargets << std::endl;
+		return false;
+	}
+
+	//both matrices have to lie inside the file
+	std::size_t size = dataTypeSize((DataType)header.dataType);
+	if (header.patternOffset + header.numEntries * header.nInputs * size > fileSize || header.targetOffset + header.numEntries * header.nTargets * size > fileSize)
+	{
+		std::cout << "Error - Data file is truncated" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool air::readDataFile(const char* begin, std::size_t size, DataStore& store)
+{
+	if (!isDataFile(begin, size))
+	{
+		std::cout << "Error - Not a readable data file" << std::endl;
+		return false;
+	}
+
+	DataFileHeader header;
+	std::memcpy(&header, begin, sizeof(header));
+	if (!checkDataFileHeader(header, size, store.nInputs, store.nTargets)) return false;
+
+	DataType type = (DataType)header.dataType;
+	store.resize((int)header.numEntries);
+	if (header.numEntries > 0)
+	{
+		readDataValues(begin + header.patternOffset, type, header.numEntries * header.nInputs, store.pattern(0));
+		readDataValues(begin + header.targetOffset, type, header.numEntries * header.nTargets, store.target(0));
+	}
+
+	return true;
+}
+
+bool air::writeDataFile(const std::string& filename, const DataStore& store, DataType type)
+{
+	if (!littleEndian())
+	{
+		std::cout << "Error - Data files can only be written on little-endian machines" << std::endl;
+		return false;
+	}
+
+	std::fstream outputFile;
+	outputFile.open(filename, std::ios::out | std::ios::binary);
+
+	if (!outputFile.is_open())
+	{
+		std::cout << "Error - Data file '" << filename << "' could not be created" << std::endl;
+		return false;
+	}
+
+	std::uint64_t patternValues = (std::uint64_t)store.size() * store.nInputs;
+	std::uint64_t targetValues = (std::uint64_t)store.size() * store.nTargets;
+
+	DataFileHeader header = {};
+	std::memcpy(header.magic, DATA_FILE_MAGIC, sizeof(header.magic));
+	header.version = DATA_FILE_VERSION;
+	header.dataType = (std::uint32_t)type;
+	header.nInputs = store.nInputs;
+	header.nTargets = store.nTargets;
+	header.numEntries = store.size();
+	header.patternOffset = aligned(sizeof(header));
+	header.targetOffset = aligned(header.patternOffset + patternValues * dataTypeSize(type));
+
+	outputFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	pad(outputFile, sizeof(header));
+
+	if (store.size() > 0)
+	{
+		writeValues(outputFile, store.pattern(0), patternValues, type);
+		pad(outputFile, header.patternOffset + patternValues * dataTypeSize(type));
+		writeValues(outputFile, store.target(0), targetValues, type);
+	}
+
+	bool success = outputFile.good();
+	outputFile.close();
+	return success;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "DataStore.hpp"
+
+/*******************************************************************
+* Binary data set file: a 64 byte header followed by the pattern and
+* the target matrix, both row-major, little-endian and starting on a
+* 64 byte boundary
+********************************************************************/
+namespace air
+{
+	//element type of the matrices in a data file
+	enum class DataType : std::uint32_t { Float64 = 0, Float32 = 1 };
+
+	const std::uint32_t DATA_FILE_VERSION = 1;
+
+	struct DataFileHeader
+	{
+		char magic[4];					//"AIRD"
+		std::uint32_t version;			//DATA_FILE_VERSION
+		std::uint32_t dataType;			//DataType
+		std::uint32_t nInputs;
+		std::uint32_t nTargets;
+		std::uint32_t reserved;
+		std::uint64_t numEntries;
+		std::uint64_t patternOffset;	//from the start of the file
+		std::uint64_t targetOffset;
+		std::uint8_t padding[16];
+	};
+	static_assert(sizeof(DataFileHeader) == 64, "data file header has to be 64 bytes");
+
+	//bytes per value of an element type
+	std::size_t dataTypeSize(DataType type);
+
+	//converts n values of the given element type to double
+	void readDataValues(const char* src, DataType type, std::size_t n, double* dst);
+
+	//checks a header against the file size and the expected dimensions, prints why a file is rejected
+	bool checkDataFileHeader(const DataFileHeader& header, std::uint64_t fileSize, int nInputs, int nTargets);
+
+	//true if the buffer starts with a data file header
+	bool isDataFile(const char* begin, std::size_t size);
+
+	//reads a mapped data file into store (which is resized), fails if the file is invalid or has other dimensions
+	bool readDataFile(const char* begin, std::size_t size, DataStore& store);
+
+	bool writeDataFile(const std::string& filename, const DataStore& store, DataType type = DataType::Float64);
+}
@@ -1,15 +1,41 @@
 #include "DataReader.hpp"
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <math.h>
 #include <algorithm>
-#include "NeuralNetwork.hpp"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "ThreadPool.hpp"
+#include "DataFile.hpp"
+#include "CsvParser.hpp"
 
 using namespace air;
 
-DataReader::DataReader() : creationApproach(NONE), numTrainingSets(-1) 
+namespace
 {
+	//smallest piece of a file worth parsing on its own thread
+	const long MIN_CHUNK_SIZE = 1 << 16;
+
+	//maps a whole file read-only
+	bool mapFile( const std::string& filename, boost::interprocess::mapped_region& region )
+	{
+		try
+		{
+			boost::interprocess::file_mapping file( filename.c_str(), boost::interprocess::read_only );
+			region = boost::interprocess::mapped_region( file, boost::interprocess::read_only );
+			return true;
+		}
+		catch ( const boost::interprocess::interprocess_exception& )
+		{
+			std::cout << "Error Opening Input File: " << filename << std::endl;
+			return false;
+		}
+	}
+}
+
+DataReader::DataReader() : creationApproach(NONE), numTrainingSets(-1), numThreads(0)
+{
+	data = std::make_shared<DataStore>();
 	tSet = std::make_shared<TrainingDataSet>();
 }
 
@@ -22,110 +48,130 @@ DataReader::~DataReader()
 }
 
 /*******************************************************************
-* Loads a csv file of input data
+* Loads a csv or binary data file (see DataFile.hpp) of input data
 ********************************************************************/
 bool DataReader::loadDataFile( const std::string& filename, int nI, int nT )
 {
-	//clear any previous data		
-	data.clear();
-	if (tSet != nullptr)
-		tSet->clear();
-	
 	//set number of inputs and outputs
 	nInputs = nI;
 	nTargets = nT;
 
-	//open file for reading
-	std::fstream inputFile;
-	inputFile.open(filename, std::ios::in);
+	//clear any previous data - start a new store and empty the current data set
+	data = std::make_shared<DataStore>(nInputs, nTargets);
+	tSet->setData(data);
 
-	if ( inputFile.is_open() )
-	{
-		std::string line = "";
-		
-		//read data
-		while ( !inputFile.eof() )
-		{
-			getline(inputFile, line);				
-			
-			//process line
-			if (line.length() > 2 ) processLine(line);
-		}		
-		
-		//shuffle data
-		random_shuffle(data.begin(), data.end());
-
-		//split data set
-		trainingDataEndIndex = (int) ( 0.6 * data.size() );
-		int gSize = (int) ( ceil(0.2 * data.size()) );
-		int vSize = (int) ( data.size() - trainingDataEndIndex - gSize );
-							
-		//generalization set
-		for ( int i = trainingDataEndIndex; i < trainingDataEndIndex + gSize; i++ ) tSet->generalizationSet.push_back( data[i] );
-				
-		//validation set
-		for ( int i = trainingDataEndIndex + gSize; i < (int) data.size(); i++ ) tSet->validationSet.push_back( data[i] );
-		
-		//print success
-		std::cout << "Input File: " << filename << "\nRead Complete: " << data.size() << " Patterns Loaded"  << std::endl;
+	//map the file into memory - the text is parsed in place
+	boost::interprocess::mapped_region region;
+	if ( !mapFile( filename, region ) ) return false;
 
-		//close file
-		inputFile.close();
-		
-		return true;
-	}
-	else 
+	const char* begin = static_cast<const char*>( region.get_address() );
+	if ( isDataFile( begin, region.get_size() ) )
 	{
-		std::cout << "Error Opening Input File: " << filename << std::endl;
-		return false;
+		if ( !readDataFile( begin, region.get_size(), *data ) ) return false;
 	}
+	else parseData( begin, begin + region.get_size(), *data );
+
+	splitData();
+
+	//print success
+	std::cout << "Input File: " << filename << "\nRead Complete: " << data->size() << " Patterns Loaded"  << std::endl;
+
+	return true;
 }
 
 /*******************************************************************
-* Processes a single line from the data file
+* Converts a csv file into a binary data file, the entries keep the
+* order of the csv file
 ********************************************************************/
-void DataReader::processLine(std::string &line )
+bool DataReader::convertDataFile( const std::string& csvFilename, const std::string& binaryFilename, int nI, int nT, DataType type )
 {
-	//create new pattern and target
-	std::vector<double> pattern = std::vector<double>(nInputs);
-	std::vector<double> target = std::vector<double>(nTargets);
-	
-	//store inputs		
-	char* cstr = new char[line.size()+1];
-	char* t;
-	strcpy(cstr, line.c_str());
-
-	//tokenise
-	int i = 0;
-	t=strtok (cstr,",");
-	
-	while ( t!=NULL && i < (nInputs + nTargets) )
-	{	
-		if ( i < nInputs ) pattern[i] = atof(t);
-		else target[i - nInputs] = atof(t);
+	boost::interprocess::mapped_region region;
+	if ( !mapFile( csvFilename, region ) ) return false;
 
-		//move token onwards
-		t = strtok(NULL,",");
-		i++;			
-	}
-	
-	/*cout << "pattern: ";
-	for (int i=0; i < nInputs; i++) 
-	{
-		cout << pattern[i] << ",";
-	}
-	
-	cout << " target: ";
-	for (int i=0; i < nTargets; i++) 
+	DataStore store( nI, nT );
+	const char* begin = static_cast<const char*>( region.get_address() );
+	parseData( begin, begin + region.get_size(), store );
+
+	if ( !writeDataFile( binaryFilename, store, type ) ) return false;
+
+	std::cout << "Converted " << store.size() << " Patterns from '" << csvFilename << "' to '" << binaryFilename << "'" << std::endl;
+	return true;
+}
+
+/*******************************************************************
+* Set number of threads used to parse data files (0 = one per
+* hardware thread)
+********************************************************************/
+void DataReader::setNumThreads( int n )
+{
+	numThreads = n;
+}
+
+/*******************************************************************
+* Parses csv text into the store. The text is split into one chunk
+* of whole lines per thread, the entries of every chunk are counted
+* first so each chunk can write straight into its rows of the store.
+********************************************************************/
+void DataReader::parseData( const char* begin, const char* end, DataStore& store )
+{
+	ThreadPool pool( numThreads );
+
+	//chunk boundaries at line starts
+	int nChunks = std::max( 1, std::min( pool.size(), (int) ( ( end - begin ) / MIN_CHUNK_SIZE ) ) );
+	std::vector<const char*> bounds( nChunks + 1, end );
+	bounds[0] = begin;
+	for ( int c = 1; c < nChunks; c++ ) bounds[c] = csv::nextLineStart( begin, std::max( bounds[c - 1], begin + ( end - begin ) * c / nChunks ), end );
+
+	//entries per chunk and first row of every chunk
+	std::vector<int> firstRow( nChunks + 1, 0 );
+	pool.run( nChunks, [&]( int c ) { firstRow[c + 1] = csv::countEntries( bounds[c], bounds[c + 1] ); } );
+	for ( int c = 0; c < nChunks; c++ ) firstRow[c + 1] += firstRow[c];
+
+	store.resize( firstRow[nChunks] );
+	pool.run( nChunks, [&]( int c ) { parseLines( bounds[c], bounds[c + 1], store, firstRow[c] ); } );
+}
+
+/*******************************************************************
+* Parses the lines in [begin, end) into the rows from firstRow on
+********************************************************************/
+void DataReader::parseLines( const char* begin, const char* end, DataStore& store, int firstRow )
+{
+	int row = firstRow;
+	for ( const char* line = begin; line < end; )
 	{
-		cout << target[i] << " ";
+		const char* e = csv::lineEnd( line, end );
+		if ( csv::isEntry( line, e ) )
+		{
+			csv::parseLine( line, e, store.pattern( row ), store.nInputs, store.target( row ), store.nTargets );
+			row++;
+		}
+		line = e + 1;
 	}
-	cout << endl;*/
+}
 
+/*******************************************************************
+* Shuffles the loaded entries and creates the generalization and
+* validation sets
+********************************************************************/
+void DataReader::splitData()
+{
+	//shuffle data - the rows are moved so every set stays contiguous in memory
+	std::vector<int> order( data->size() );
+	for ( int i = 0; i < data->size(); i++ ) order[i] = i;
+	std::shuffle( order.begin(), order.end(), rng );
+	data->permute(order);
 
-	//add to records
-	data.push_back(std::make_shared<DataEntry>(pattern, target));		
+	//split data set
+	trainingDataEndIndex = (int) ( 0.6 * data->size() );
+	int gSize = (int) ( ceil(0.2 * data->size()) );
+
+	//generalization set
+	tSet->generalizationSet.setRange( trainingDataEndIndex, trainingDataEndIndex + gSize );
+
+	//validation set
+	tSet->validationSet.setRange( trainingDataEndIndex + gSize, data->size() );
 }
+
 /*******************************************************************
 * Selects the data set creation approach
 ********************************************************************/
@@ -160,7 +206,7 @@ void DataReader::setCreationApproach( int approach, double param1, double param2
 	else if ( approach == WINDOWING )
 	{
 		//if initial size smaller than total entries and step size smaller than set size
-		if ( param1 < data.size() && param2 <= param1)
+		if ( param1 < data->size() && param2 <= param1)
 		{
 			creationApproach = WINDOWING;
 			
@@ -199,7 +245,7 @@ std::shared_ptr<TrainingDataSet> DataReader::getTrainingDataSet()
 /*******************************************************************
 * Get all data entries loaded
 ********************************************************************/
-std::vector<std::shared_ptr<DataEntry>>& DataReader::getAllDataEntries()
+std::shared_ptr<const DataStore> DataReader::getAllDataEntries()
 {
 	return data;
 }
@@ -210,7 +256,7 @@ std::vector<std::shared_ptr<DataEntry>>& DataReader::getAllDataEntries()
 void DataReader::createStaticDataSet()
 {
 	//training set
-	for ( int i = 0; i < trainingDataEndIndex; i++ ) tSet->trainingSet.push_back( data[i] );		
+	tSet->trainingSet.setRange( 0, trainingDataEndIndex );		
 }
 /*******************************************************************
 * Create a growing data set (contains only a percentage of entries
@@ -222,11 +268,8 @@ void DataReader::createGrowingDataSet()
 	growingLastDataIndex += (int) ceil( growingStepSize * trainingDataEndIndex );		
 	if ( growingLastDataIndex > (int) trainingDataEndIndex ) growingLastDataIndex = trainingDataEndIndex;
 
-	//clear sets
-	tSet->trainingSet.clear();
-	
 	//training set
-	for ( int i = 0; i < growingLastDataIndex; i++ ) tSet->trainingSet.push_back( data[i] );			
+	tSet->trainingSet.setRange( 0, growingLastDataIndex );			
 }
 /*******************************************************************
 * Create a windowed data set ( creates a window over a part of the data
@@ -238,11 +281,8 @@ void DataReader::createWindowingDataSet()
 	int endIndex = windowingStartIndex + windowingSetSize;
 	if ( endIndex > trainingDataEndIndex ) endIndex = trainingDataEndIndex;		
 
-	//clear sets
-	tSet->trainingSet.clear();
-					
 	//training set
-	for ( int i = windowingStartIndex; i < endIndex; i++ ) tSet->trainingSet.push_back( data[i] );
+	tSet->trainingSet.setRange( windowingStartIndex, endIndex );
 			
 	//increase start index
 	windowingStartIndex += windowingStepSize;
@@ -2,7 +2,9 @@
 #include <vector>
 #include <string>
 #include <memory>
-#include "DataEntry.hpp"
+#include <random>
+#include "DataStore.hpp"
+#include "DataFile.hpp"
 #include "TrainingDataSet.hpp"
 
 namespace air
@@ -17,22 +19,30 @@ namespace air
 		~DataReader();
 
 		bool loadDataFile(const std::string& filename, int nI, int nT);
+		bool convertDataFile(const std::string& csvFilename, const std::string& binaryFilename, int nI, int nT, DataType type = DataType::Float64);
+		void setNumThreads(int n);
+
+		//seed of the shuffle that splits the loaded entries into sets
+		void setSeed(unsigned int seed) { rng.seed(seed); }
+
 		void setCreationApproach(int approach, double param1 = -1, double param2 = -1);
 		int getNumTrainingSets();
 
 		std::shared_ptr<TrainingDataSet> getTrainingDataSet();
-		std::vector<std::shared_ptr<DataEntry>>& getAllDataEntries();
+		std::shared_ptr<const DataStore> getAllDataEntries();
 
 	private:
 		void createStaticDataSet();
 		void createGrowingDataSet();
 		void createWindowingDataSet();
-		void processLine(std::string &line);
+		void parseData(const char* begin, const char* end, DataStore& store);
+		void parseLines(const char* begin, const char* end, DataStore& store, int firstRow);
+		void splitData();
 
 	private:
 
 		//data storage
-		std::vector<std::shared_ptr<DataEntry>> data;
+		std::shared_ptr<DataStore> data;
 		int nInputs;
 		int nTargets;
 
@@ -50,6 +60,12 @@ namespace air
 		int windowingSetSize;			//initial size of set
 		int windowingStepSize;			//how many entries to move window by
 		int windowingStartIndex;		//window start index	
+
+		//threads used for parsing (0 = one per hardware thread)
+		int numThreads;
+
+		//shuffles the entries before they are split
+		std::mt19937 rng;
 	};
 }
 
@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "Matrix.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* All loaded entries as two contiguous row-major matrices, one row
+	* of nInputs pattern values and one row of nTargets target values
+	* per entry
+	********************************************************************/
+	class DataStore
+	{
+	public:
+		DataStore() : nInputs(0), nTargets(0), numEntries(0) {}
+		DataStore(int nI, int nT) : nInputs(nI), nTargets(nT), numEntries(0) {}
+
+		int size() const { return numEntries; }
+
+		void reserve(int n)
+		{
+			patterns.reserve((size_t)n * nInputs);
+			targets.reserve((size_t)n * nTargets);
+		}
+
+		void addEntry(const double* pattern, const double* target)
+		{
+			patterns.insert(patterns.end(), pattern, pattern + nInputs);
+			targets.insert(targets.end(), target, target + nTargets);
+			numEntries++;
+		}
+
+		//set the number of entries, new entries are all 0
+		void resize(int n)
+		{
+			patterns.resize((size_t)n * nInputs, 0.0);
+			targets.resize((size_t)n * nTargets, 0.0);
+			numEntries = n;
+		}
+
+		const double* pattern(int i) const { return patterns.data() + (size_t)i * nInputs; }
+		const double* target(int i) const { return targets.data() + (size_t)i * nTargets; }
+		double* pattern(int i) { return patterns.data() + (size_t)i * nInputs; }
+		double* target(int i) { return targets.data() + (size_t)i * nTargets; }
+
+		MatrixView<const double> patternMatrix() const { return MatrixView<const double>(patterns.data(), numEntries, nInputs); }
+		MatrixView<const double> targetMatrix() const { return MatrixView<const double>(targets.data(), numEntries, nTargets); }
+
+		//reorder the entries so entry i is the former entry order[i]
+		void permute(const std::vector<int>& order)
+		{
+			AlignedVector<double> p(patterns.size()), t(targets.size());
+			for (int i = 0; i < (int)order.size(); i++)
+			{
+				std::copy(pattern(order[i]), pattern(order[i]) + nInputs, p.begin() + (size_t)i * nInputs);
+				std::copy(target(order[i]), target(order[i]) + nTargets, t.begin() + (size_t)i * nTargets);
+			}
+			patterns.swap(p);
+			targets.swap(t);
+		}
+
+	public:
+		int nInputs;
+		int nTargets;
+
+	private:
+		int numEntries;
+		AlignedVector<double> patterns;		//numEntries x nInputs
+		AlignedVector<double> targets;		//numEntries x nTargets
+	};
+
+	/*******************************************************************
+	* Contiguous range of entries of a data store, creating or moving
+	* one only sets two numbers
+	********************************************************************/
+	class DataSubset
+	{
+	public:
+		DataSubset() : store(nullptr), begin(0), count(0) {}
+		DataSubset(const DataStore* s, int b = 0, int n = 0) : store(s), begin(b), count(n) {}
+
+		int size() const { return count; }
+		bool empty() const { return count == 0; }
+		void clear() { begin = count = 0; }
+
+		//entries [first, last) of the store
+		void setRange(int first, int last)
+		{
+			begin = first;
+			count = last > first ? last - first : 0;
+		}
+
+		const double* pattern(int i) const { return store->pattern(begin + i); }
+		const double* target(int i) const { return store->target(begin + i); }
+
+	public:
+		const DataStore* store;
+		int begin;
+		int count;
+	};
+}
@@ -0,0 +1,327 @@
+#include "DataStream.hpp"
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include "CsvParser.hpp"
+
+using namespace air;
+
+namespace
+{
+	//chunks read ahead of the consumer
+	const int MAX_QUEUED_CHUNKS = 2;
+
+	//bytes read from a csv file at once
+	const std::size_t TEXT_BLOCK_SIZE = 1 << 20;
+}
+
+DataStream::DataStream(int nI, int nT, int cSize, int bSize) : nInputs(nI), nTargets(nT), chunkSize(std::max(cSize, 1)), shuffleBufferSize(std::max(bSize, 1)),
+	binary(false), nextRow(0), textPos(0), endOfFile(false), rewindRequested(false), stopping(false),
+	currentRow(0), draining(false), buffer(nI, nT), bufferCount(0)
+{
+	buffer.resize(shuffleBufferSize);
+}
+
+DataStream::~DataStream()
+{
+	close();
+}
+
+/*******************************************************************
+* Opens a csv or binary data file and starts reading ahead
+********************************************************************/
+bool DataStream::open(const std::string& filename)
+{
+	close();
+
+	file.open(filename, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Error Opening Input File: " << filename << std::endl;
+		return false;
+	}
+
+	//binary data files start with a header
+	file.seekg(0, std::ios::end);
+	std::uint64_t fileSize = (std::uint64_t)file.tellg();
+	file.seekg(0);
+
+	binary = false;
+	if (fileSize >= sizeof(header))
+	{
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		binary = isDataFile(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (binary && !checkDataFileHeader(header, fileSize, nInputs, nTargets))
+		{
+			file.close();
+			return false;
+		}
+	}
+
+	seekStart();
+	endOfFile = rewindRequested = stopping = false;
+	current.reset();
+	currentRow = bufferCount = 0;
+	draining = false;
+
+	prefetchThread = std::thread(&DataStream::prefetchLoop, this);
+	return true;
+}
+
+void DataStream::close()
+{
+	if (prefetchThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		chunkTaken.notify_all();
+		prefetchThread.join();
+	}
+
+	ready.clear();
+	current.reset();
+	if (file.is_open()) file.close();
+}
+
+std::string DataStream::rngState() const
+{
+	std::ostringstream s;
+	s << rng;
+	return s.str();
+}
+
+void DataStream::setRngState(const std::string& state)
+{
+	std::istringstream s(state);
+	s >> rng;
+}
+
+/*******************************************************************
+* Starts a new pass, drops everything read ahead of the old one
+********************************************************************/
+void DataStream::rewind()
+{
+	current.reset();
+	currentRow = bufferCount = 0;
+	draining = false;
+	if (!prefetchThread.joinable()) return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	rewindRequested = true;
+	ready.clear();
+	chunkTaken.notify_all();
+
+	//once the flag is cleared every queued chunk belongs to the new pass
+	chunkReady.wait(lock, [this] { return !rewindRequested || stopping; });
+}
+
+/*******************************************************************
+* Fills batch with up to n entries. Every entry read replaces a random
+* entry of the full shuffle buffer, which is handed out instead. Once
+* the file is exhausted the buffer is emptied in random order.
+********************************************************************/
+int DataStream::nextBatch(DataStore& batch, int n)
+{
+	batch.nInputs = nInputs;
+	batch.nTargets = nTargets;
+	batch.resize(n);
+
+	int count = 0;
+	const double* pattern;
+	const double* target;
+
+	while (count < n)
+	{
+		if (!draining && nextEntry(pattern, target))
+		{
+			//still filling the buffer
+			if (bufferCount < shuffleBufferSize)
+			{
+				std::copy(pattern, pattern + nInputs, buffer.pattern(bufferCount));
+				std::copy(target, target + nTargets, buffer.target(bufferCount));
+				bufferCount++;
+				continue;
+			}
+
+			//hand out a random buffered entry and put the new one in its place
+			int r = (int)(rng() % bufferCount);
+			std::copy(buffer.pattern(r), buffer.pattern(r) + nInputs, batch.pattern(count));
+			std::copy(buffer.target(r), buffer.target(r) + nTargets, batch.target(count));
+			std::copy(pattern, pattern + nInputs, buffer.pattern(r));
+			std::copy(target, target + nTargets, buffer.target(r));
+			count++;
+		}
+		else
+		{
+			draining = true;
+			if (bufferCount == 0) break;
+
+			//hand out a random buffered entry and fill the gap with the last one
+			int r = (int)(rng() % bufferCount);
+			int last = --bufferCount;
+			std::copy(buffer.pattern(r), buffer.pattern(r) + nInputs, batch.pattern(count));
+			std::copy(buffer.target(r), buffer.target(r) + nTargets, batch.target(count));
+			std::copy(buffer.pattern(last), buffer.pattern(last) + nInputs, buffer.pattern(r));
+			std::copy(buffer.target(last), buffer.target(last) + nTargets, buffer.target(r));
+			count++;
+		}
+	}
+
+	batch.resize(count);
+	return count;
+}
+
+/*******************************************************************
+* Next entry in file order, waits for the prefetch thread if needed
+********************************************************************/
+bool DataStream::nextEntry(const double*& pattern, const double*& target)
+{
+	if (current == nullptr || currentRow == current->size())
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		chunkReady.wait(lock, [this] { return !ready.empty() || stopping || !prefetchThread.joinable(); });
+		if (ready.empty()) return false;
+
+		current = std::move(ready.front());
+		ready.pop_front();
+		currentRow = 0;
+		chunkTaken.notify_all();
+
+		//empty chunk - end of the file
+		if (current->size() == 0) return false;
+	}
+
+	pattern = current->pattern(currentRow);
+	target = current->target(currentRow);
+	currentRow++;
+	return true;
+}
+
+void DataStream::prefetchLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	while (true)
+	{
+		chunkTaken.wait(lock, [this] { return stopping || rewindRequested || (!endOfFile && (int)ready.size() < MAX_QUEUED_CHUNKS); });
+		if (stopping) break;
+
+		if (rewindRequested)
+		{
+			seekStart();
+			ready.clear();
+			endOfFile = false;
+			rewindRequested = false;
+			chunkReady.notify_all();
+			continue;
+		}
+
+		//read without holding the lock
+		lock.unlock();
+		std::unique_ptr<DataStore> chunk(new DataStore(nInputs, nTargets));
+		bool more = readChunk(*chunk);
+		lock.lock();
+
+		//a rewind while reading makes the chunk stale
+		if (rewindRequested || stopping) continue;
+
+		if (chunk->size() > 0) ready.push_back(std::move(chunk));
+		if (!more)
+		{
+			ready.push_back(std::unique_ptr<DataStore>(new DataStore(nInputs, nTargets)));
+			endOfFile = true;
+		}
+		chunkReady.notify_all();
+	}
+
+	chunkReady.notify_all();
+}
+
+void DataStream::seekStart()
+{
+	file.clear();
+	if (binary) nextRow = 0;
+	else
+	{
+		file.seekg(0);
+		text.clear();
+		textPos = 0;
+	}
+}
+
+/*******************************************************************
+* Reads up to chunkSize entries, returns false at the end of the file
+********************************************************************/
+bool DataStream::readChunk(DataStore& chunk)
+{
+	return binary ? readBinaryChunk(chunk) : readCsvChunk(chunk);
+}
+
+bool DataStream::readCsvChunk(DataStore& chunk)
+{
+	chunk.resize(chunkSize);
+	int count = 0;
+	bool more = true;
+
+	while (count < chunkSize)
+	{
+		const char* begin = text.data() + textPos;
+		const char* end = text.data() + text.size();
+		const char* e = csv::lineEnd(begin, end);
+
+		//incomplete line - keep the rest and read the next block
+		if (e == end && more)
+		{
+			text.erase(text.begin(), text.begin() + textPos);
+			textPos = 0;
+
+			std::size_t kept = text.size();
+			text.resize(kept + TEXT_BLOCK_SIZE);
+			file.read(text.data() + kept, TEXT_BLOCK_SIZE);
+			text.resize(kept + (std::size_t)file.gcount());
+			more = !file.eof() && file.good();
+			continue;
+		}
+
+		//last line without a line break
+		if (begin == end) break;
+
+		if (csv::isEntry(begin, e))
+		{
+			csv::parseLine(begin, e, chunk.pattern(count), nInputs, chunk.target(count), nTargets);
+			count++;
+		}
+		textPos = std::min((std::size_t)(e - text.data()) + 1, text.size());
+	}
+
+	chunk.resize(count);
+	return more || textPos < text.size();
+}
+
+bool DataStream::readBinaryChunk(DataStore& chunk)
+{
+	DataType type = (DataType)header.dataType;
+	std::size_t valueSize = dataTypeSize(type);
+	int count = (int)std::min<std::uint64_t>(chunkSize, header.numEntries - nextRow);
+
+	chunk.resize(count);
+	if (count > 0)
+	{
+		//patterns and targets of the chunk are contiguous in their matrices
+		raw.resize((std::size_t)count * std::max(nInputs, nTargets) * valueSize);
+
+		file.seekg(header.patternOffset + nextRow * nInputs * valueSize);
+		file.read(raw.data(), (std::size_t)count * nInputs * valueSize);
+		readDataValues(raw.data(), type, (std::size_t)count * nInputs, chunk.pattern(0));
+
+		file.seekg(header.targetOffset + nextRow * nTargets * valueSize);
+		file.read(raw.data(), (std::size_t)count * nTargets * valueSize);
+		readDataValues(raw.data(), type, (std::size_t)count * nTargets, chunk.target(0));
+
+		nextRow += count;
+	}
+
+	return nextRow < header.numEntries;
+}
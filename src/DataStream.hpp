@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <cstdint>
+#include "DataStore.hpp"
+#include "DataFile.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Out-of-core source of training entries. A background thread reads
+	* a csv or binary data file in chunks of a fixed number of entries,
+	* the entries pass through a bounded shuffle buffer on their way to
+	* the caller. Memory use depends only on the chunk and buffer sizes,
+	* never on the size of the file.
+	********************************************************************/
+	class DataStream
+	{
+	public:
+		DataStream(int nInputs, int nTargets, int chunkSize = 4096, int shuffleBufferSize = 65536);
+		~DataStream();
+
+		bool open(const std::string& filename);
+		void close();
+
+		//seed of the shuffle buffer's random number generator
+		void setSeed(unsigned int seed) { rng.seed(seed); }
+
+		//state of the shuffle buffer's random number generator, restoring it before a pass repeats that pass's order
+		std::string rngState() const;
+		void setRngState(const std::string& state);
+
+		//starts a new pass over the file
+		void rewind();
+
+		//moves up to n shuffled entries into batch (resized to the count), returns 0 once the pass is complete
+		int nextBatch(DataStore& batch, int n);
+
+	private:
+		void prefetchLoop();
+		bool readChunk(DataStore& chunk);
+		bool readCsvChunk(DataStore& chunk);
+		bool readBinaryChunk(DataStore& chunk);
+		void seekStart();
+		bool nextEntry(const double*& pattern, const double*& target);
+
+	public:
+		int nInputs;
+		int nTargets;
+
+	private:
+		int chunkSize;
+		int shuffleBufferSize;
+
+		//file - only touched by the prefetch thread while it runs
+		std::ifstream file;
+		bool binary;
+		DataFileHeader header;
+		std::uint64_t nextRow;				//binary: next entry to read
+		std::vector<char> text;				//csv: read text not parsed yet
+		std::size_t textPos;
+		std::vector<char> raw;				//binary: values as stored in the file
+
+		//chunks read ahead, an empty chunk marks the end of the file
+		std::thread prefetchThread;
+		std::mutex mutex;
+		std::condition_variable chunkReady;
+		std::condition_variable chunkTaken;
+		std::deque<std::unique_ptr<DataStore>> ready;
+		bool endOfFile;
+		bool rewindRequested;
+		bool stopping;
+
+		//consumer side
+		std::unique_ptr<DataStore> current;
+		int currentRow;
+		bool draining;						//file exhausted, only the shuffle buffer is left
+		DataStore buffer;
+		int bufferCount;
+		std::mt19937 rng;
+	};
+}
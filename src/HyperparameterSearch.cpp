@@ -0,0 +1,203 @@
+#include "HyperparameterSearch.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <mutex>
+#include <chrono>
+#include <math.h>
+#include "ThreadPool.hpp"
+
+using namespace air;
+
+HyperparameterSearch::HyperparameterSearch(std::shared_ptr<TrainingDataSet> tSet) :	dataSet(tSet),
+																				maxEpochs(MAX_EPOCHS),
+																				desiredAccuracy(DESIRED_ACCURACY),
+																				numThreads(0),
+																				seed(1)
+{
+}
+
+void HyperparameterSearch::setStoppingConditions(int mEpochs, double dAccuracy)
+{
+	maxEpochs = mEpochs;
+	desiredAccuracy = dAccuracy;
+}
+
+//every list needs at least one value
+static bool checkSpace(const SearchSpace& space)
+{
+	if (space.hiddenNeurons.empty() || space.hiddenLayers.empty() || space.learningRates.empty() || space.momenta.empty() || space.batchSizes.empty())
+	{
+		std::cout << std::endl << "Error - Every parameter of a search space needs at least one value" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/*******************************************************************
+* Every combination of the values of the space
+********************************************************************/
+std::vector<SearchTrial> HyperparameterSearch::gridTrials(const SearchSpace& space) const
+{
+	std::vector<SearchTrial> trials;
+	if (!checkSpace(space)) return trials;
+
+	for (int layers : space.hiddenLayers)
+	{
+		for (int neurons : space.hiddenNeurons)
+		{
+			for (double lR : space.learningRates)
+			{
+				for (double m : space.momenta)
+				{
+					for (int batch : space.batchSizes)
+					{
+						SearchTrial t;
+						t.hiddenLayers = layers;
+						t.hiddenNeurons = neurons;
+						t.learningRate = lR;
+						t.momentum = m;
+						t.batchSize = batch;
+						t.seed = seed + (unsigned int)trials.size();
+						trials.push_back(t);
+					}
+				}
+			}
+		}
+	}
+	return trials;
+}
+
+/*******************************************************************
+* nTrials random combinations, drawn from the ranges spanned by the
+* values of the space
+********************************************************************/
+std::vector<SearchTrial> HyperparameterSearch::randomTrials(const SearchSpace& space, int nTrials) const
+{
+	std::vector<SearchTrial> trials;
+	if (!checkSpace(space)) return trials;
+
+	auto neurons = std::minmax_element(space.hiddenNeurons.begin(), space.hiddenNeurons.end());
+	auto rates = std::minmax_element(space.learningRates.begin(), space.learningRates.end());
+	auto momenta = std::minmax_element(space.momenta.begin(), space.momenta.end());
+
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> neuronDistribution(*neurons.first, *neurons.second);
+	std::uniform_real_distribution<double> rateDistribution(log(*rates.first), log(*rates.second));
+	std::uniform_real_distribution<double> momentumDistribution(*momenta.first, *momenta.second);
+	std::uniform_int_distribution<int> layerDistribution(0, (int)space.hiddenLayers.size() - 1);
+	std::uniform_int_distribution<int> batchDistribution(0, (int)space.batchSizes.size() - 1);
+
+	for (int i = 0; i < nTrials; i++)
+	{
+		SearchTrial t;
+		t.hiddenLayers = space.hiddenLayers[layerDistribution(rng)];
+		t.hiddenNeurons = neuronDistribution(rng);
+		t.learningRate = exp(rateDistribution(rng));
+		t.momentum = momentumDistribution(rng);
+		t.batchSize = space.batchSizes[batchDistribution(rng)];
+		t.seed = seed + (unsigned int)i;
+		trials.push_back(t);
+	}
+	return trials;
+}
+
+/*******************************************************************
+* Train all trials, numThreads at a time, and rank them
+********************************************************************/
+std::vector<SearchTrial> HyperparameterSearch::run(std::vector<SearchTrial> trials)
+{
+	ThreadPool pool(numThreads);
+	std::cout << std::endl << " Hyperparameter Search: " << trials.size() << " Trials on " << pool.size() << " Threads, Max Epochs: " << maxEpochs << std::endl
+			<< "==========================================================================" << std::endl;
+
+	std::mutex outputMutex;
+	int finished = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	pool.run((int)trials.size(), [&](int i)
+	{
+		train(trials[i]);
+
+		std::lock_guard<std::mutex> lock(outputMutex);
+		const SearchTrial& t = trials[i];
+		std::cout << "Trial " << ++finished << "/" << trials.size() << ": " << t.hiddenLayers << "x" << t.hiddenNeurons << " Hidden, LR: " << t.learningRate
+			<< ", Momentum: " << t.momentum << ", Batch Size: " << t.batchSize << " -> GSet Acc: " << t.generalization.accuracy << "%, MSE: " << t.generalization.mse
+			<< " (" << t.epochs << " Epochs, " << t.seconds << "s)" << std::endl;
+	});
+
+	std::cout << std::endl << "Search Complete!!! - > Elapsed Time: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s" << std::endl;
+
+	std::stable_sort(trials.begin(), trials.end(), [](const SearchTrial& a, const SearchTrial& b)
+	{
+		if (a.generalization.accuracy != b.generalization.accuracy) return a.generalization.accuracy > b.generalization.accuracy;
+		return a.generalization.mse < b.generalization.mse;
+	});
+	return trials;
+}
+
+void HyperparameterSearch::train(SearchTrial& trial) const
+{
+	auto start = std::chrono::steady_clock::now();
+
+	//initial weights from the trial's own engine, rand() is shared by the whole process
+	std::mt19937 rng(trial.seed);
+	auto nn = std::make_shared<NeuralNetwork>(dataSet->data->nInputs, trial.hiddenNeurons, trial.hiddenLayers, dataSet->data->nTargets, rng);
+
+	NeuralNetworkTrainer trainer(nn);
+	trainer.setVerbose(false);
+	trainer.setTrainingParameters(trial.learningRate, trial.momentum, false);
+	trainer.setBatchSize(trial.batchSize);
+	trainer.setStoppingConditions(maxEpochs, desiredAccuracy);
+	trainer.trainNetwork(dataSet);
+
+	trial.epochs = trainer.getEpochs();
+	trial.generalization = trainer.getGeneralizationStats();
+	trial.validation = trainer.getValidationStats();
+	trial.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HyperparameterSearch::printResults(const std::vector<SearchTrial>& trials, int maxRows)
+{
+	int rows = maxRows > 0 ? std::min(maxRows, (int)trials.size()) : (int)trials.size();
+
+	std::cout << std::endl << std::left << std::setw(6) << "Rank" << std::setw(10) << "Hidden" << std::setw(12) << "LR" << std::setw(10) << "Momentum"
+		<< std::setw(7) << "Batch" << std::setw(8) << "Epochs" << std::setw(10) << "GSet Acc" << std::setw(12) << "GSet MSE"
+		<< std::setw(10) << "VSet Acc" << std::setw(12) << "VSet MSE" << "Time" << std::endl;
+
+	for (int r = 0; r < rows; r++)
+	{
+		const SearchTrial& t = trials[r];
+		std::ostringstream hidden;
+		hidden << t.hiddenLayers << "x" << t.hiddenNeurons;
+
+		std::cout << std::setw(6) << r + 1 << std::setw(10) << hidden.str() << std::setw(12) << t.learningRate << std::setw(10) << t.momentum
+			<< std::setw(7) << t.batchSize << std::setw(8) << t.epochs << std::setw(10) << t.generalization.accuracy << std::setw(12) << t.generalization.mse
+			<< std::setw(10) << t.validation.accuracy << std::setw(12) << t.validation.mse << t.seconds << "s" << std::endl;
+	}
+	std::cout << std::right;
+}
+
+bool HyperparameterSearch::saveResults(const std::string& filename, const std::vector<SearchTrial>& trials)
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << std::endl << "Error - Results file '" << filename << "' could not be created" << std::endl;
+		return false;
+	}
+
+	file << "rank,hidden layers,hidden neurons,learning rate,momentum,batch size,seed,epochs,generalization accuracy,generalization mse,validation accuracy,validation mse,seconds" << std::endl;
+	for (int r = 0; r < (int)trials.size(); r++)
+	{
+		const SearchTrial& t = trials[r];
+		file << r + 1 << "," << t.hiddenLayers << "," << t.hiddenNeurons << "," << t.learningRate << "," << t.momentum << "," << t.batchSize << "," << t.seed << ","
+			<< t.epochs << "," << t.generalization.accuracy << "," << t.generalization.mse << "," << t.validation.accuracy << "," << t.validation.mse << "," << t.seconds << std::endl;
+	}
+
+	std::cout << std::endl << "Search results saved to '" << filename << "'" << std::endl;
+	return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include "TrainingDataSet.hpp"
+#include "NeuralNetwork.hpp"
+#include "NeuralNetworkTrainer.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Values tried by a search. A grid search trains every combination;
+	* a random search draws the learning rate (on a log scale), the
+	* momentum and the hidden neurons from the range spanned by their
+	* listed values and picks hidden layers and batch size from the lists.
+	********************************************************************/
+	struct SearchSpace
+	{
+		std::vector<int> hiddenNeurons;						//per hidden layer
+		std::vector<int> hiddenLayers = { 1 };
+		std::vector<double> learningRates = { LEARNING_RATE };
+		std::vector<double> momenta = { MOMENTUM };
+		std::vector<int> batchSizes = { 1 };
+	};
+
+	//one configuration of a search and the results of training it
+	struct SearchTrial
+	{
+		int hiddenNeurons = 0;
+		int hiddenLayers = 1;
+		double learningRate = LEARNING_RATE;
+		double momentum = MOMENTUM;
+		int batchSize = 1;
+		unsigned int seed = 0;								//seed of the std::mt19937 the initial weights are drawn from
+
+		long epochs = 0;
+		SetStats generalization = { 0, 0 };
+		SetStats validation = { 0, 0 };
+		double seconds = 0;
+	};
+
+	/*******************************************************************
+	* Trains many independent networks in parallel, one trial per
+	* thread at a time. All trials read the same data set; every trial
+	* owns its network and a single threaded, quiet trainer, and the
+	* thread pool hands the next trial to whichever thread is free.
+	*
+	* Every trial creates its network on its worker thread from its own
+	* std::mt19937 seeded with the trial's seed, never from rand(), so
+	* the results depend neither on the number of threads nor on other
+	* rand() users, and any trial can be retrained on its own by
+	* creating its network from the same seed. Trials are ranked by
+	* generalization accuracy, then generalization MSE; the validation
+	* set plays no part in the ranking.
+	********************************************************************/
+	class HyperparameterSearch
+	{
+	public:
+		HyperparameterSearch(std::shared_ptr<TrainingDataSet> tSet);
+
+		void setStoppingConditions(int mEpochs, double dAccuracy);
+
+		//threads running trials (0 = one per hardware thread)
+		void setNumThreads(int n) { numThreads = n; }
+
+		//trial i is seeded with seed + i, random searches draw their trials from seed as well
+		void setSeed(unsigned int s) { seed = s; }
+
+		//trials of a search, empty if a list of the space is empty
+		std::vector<SearchTrial> gridTrials(const SearchSpace& space) const;
+		std::vector<SearchTrial> randomTrials(const SearchSpace& space, int nTrials) const;
+
+		//trains all trials and returns them ranked, best first
+		std::vector<SearchTrial> run(std::vector<SearchTrial> trials);
+
+		//ranked table on the console (maxRows = 0 prints all) and as a csv file
+		static void printResults(const std::vector<SearchTrial>& trials, int maxRows = 0);
+		static bool saveResults(const std::string& filename, const std::vector<SearchTrial>& trials);
+
+	private:
+		void train(SearchTrial& trial) const;
+
+	private:
+		std::shared_ptr<TrainingDataSet> dataSet;
+
+		int maxEpochs;
+		double desiredAccuracy;
+		int numThreads;
+		unsigned int seed;
+	};
+}
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "NeuralNetwork.hpp"
+#include "StaticNetwork.hpp"
+#include "Kernels.hpp"
+
+using namespace air;
+
+/*******************************************************************
+* Latency of single pattern inference (NeuralNetwork::classify and
+* predict, StaticNetwork<16, 20, 3>) and the number of heap
+* allocations per call. Every call
+* through operator new is counted, the benchmark fails if a timed
+* call allocated.
+*
+* usage: air-bench-inference [calls]
+********************************************************************/
+
+static std::atomic<long long> allocations(0);
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+//calls per timing sample, a single call is too short for the clock
+static const int CALLS_PER_SAMPLE = 64;
+
+struct Result
+{
+	double median;			//nanoseconds per call
+	double p99;
+	double allocationsPerCall;
+};
+
+template<typename Call>
+static Result measure(int calls, Call call)
+{
+	int samples = std::max(1, calls / CALLS_PER_SAMPLE);
+	std::vector<double> times(samples);
+
+	//warm up caches and the branch predictor
+	for (int i = 0; i < CALLS_PER_SAMPLE; i++) call(i);
+
+	long long startAllocations = allocations;
+	for (int s = 0; s < samples; s++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < CALLS_PER_SAMPLE; i++) call(s * CALLS_PER_SAMPLE + i);
+		times[s] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / CALLS_PER_SAMPLE;
+	}
+	long long callAllocations = allocations - startAllocations;
+
+	std::sort(times.begin(), times.end());
+
+	Result r;
+	r.median = times[samples / 2];
+	r.p99 = times[std::min(samples - 1, samples * 99 / 100)];
+	r.allocationsPerCall = (double)callAllocations / ((long long)samples * CALLS_PER_SAMPLE);
+	return r;
+}
+
+static void print(const char* name, const Result& r)
+{
+	std::cout << " " << name << ": median " << r.median << " ns, p99 " << r.p99 << " ns, " << r.allocationsPerCall << " allocations per call" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int calls = argc > 1 ? std::max(atoi(argv[1]), 1) : 1 << 20;
+
+	//the game network with random weights, queried with random patterns
+	srand(1);
+	NeuralNetwork nn(std::vector<int>{ 16, 20, 3 });
+	NeuralNetworkF nnF(nn.topology);
+
+	StaticNetwork<16, 20, 3> fixed;
+	StaticNetworkF<16, 20, 3> fixedF;
+	fixed.load(nn);
+	fixedF.load(nn);
+
+	const int numPatterns = 1024;
+	std::vector<double> patterns(numPatterns * nn.nInput);
+	for (auto& v : patterns) v = (double)rand() / RAND_MAX;
+
+	std::vector<int> results(nn.nOutput);
+	std::vector<double> outputs(nn.nOutput);
+	std::vector<float> outputsF(nn.nOutput);
+	int checksum = 0;
+
+	std::cout << std::endl << "Single pattern inference, " << nn.nInput << "-20-" << nn.nOutput << " network, " << kernels::table<double>().name << " kernels, " << calls << " calls" << std::endl;
+
+	Result classify = measure(calls, [&](int i) { nn.classify(&patterns[(i % numPatterns) * nn.nInput], results.data()); checksum += results[0]; });
+	Result predict = measure(calls, [&](int i) { nn.predict(&patterns[(i % numPatterns) * nn.nInput], outputs.data()); });
+	Result predictF = measure(calls, [&](int i) { nnF.predict(&patterns[(i % numPatterns) * nn.nInput], outputsF.data()); });
+	Result fixedPredict = measure(calls, [&](int i) { fixed.predict(&patterns[(i % numPatterns) * nn.nInput], outputs.data()); });
+	Result fixedPredictF = measure(calls, [&](int i) { fixedF.predict(&patterns[(i % numPatterns) * nn.nInput], outputsF.data()); });
+	Result legacy = measure(calls, [&](int i)
+	{
+		std::vector<double> pattern(patterns.begin() + (i % numPatterns) * nn.nInput, patterns.begin() + (i % numPatterns + 1) * nn.nInput);
+		checksum += nn.feedForwardPattern(pattern)[0];
+	});
+
+	print("classify         ", classify);
+	print("predict (double) ", predict);
+	print("predict (float)  ", predictF);
+	print("static (double)  ", fixedPredict);
+	print("static (float)   ", fixedPredictF);
+	print("feedForwardPattern", legacy);
+	std::cout << " checksum " << checksum << std::endl;
+
+	if (classify.allocationsPerCall > 0 || predict.allocationsPerCall > 0 || predictF.allocationsPerCall > 0 || fixedPredict.allocationsPerCall > 0
+		|| fixedPredictF.allocationsPerCall > 0)
+	{
+		std::cout << std::endl << "Error - Single pattern inference allocated" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
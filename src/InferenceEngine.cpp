@@ -0,0 +1,122 @@
+#include "InferenceEngine.hpp"
+#include <algorithm>
+
+using namespace air;
+
+//empty polls before an engine thread goes to sleep
+static const int IDLE_SPINS = 64;
+
+template<typename Real>
+BasicInferenceEngine<Real>::BasicInferenceEngine(std::shared_ptr<Publisher> p, int numThreads, int size, int queueCapacity) :
+	publisher(p), batchSize(std::max(size, 1)), queue(queueCapacity), sleepers(0), stopping(false)
+{
+	if (numThreads <= 0) numThreads = ThreadPool::hardwareThreads();
+	for (int i = 0; i < numThreads; i++) threads.push_back(std::thread(&BasicInferenceEngine::workerLoop, this));
+}
+
+template<typename Real>
+BasicInferenceEngine<Real>::BasicInferenceEngine(const Network& nn, int numThreads, int size, int queueCapacity) :
+	BasicInferenceEngine(std::make_shared<Publisher>(nn), numThreads, size, queueCapacity)
+{
+
+}
+
+template<typename Real>
+BasicInferenceEngine<Real>::~BasicInferenceEngine()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	//queued requests are still answered
+	for (auto& t : threads) t.join();
+}
+
+template<typename Real>
+bool BasicInferenceEngine<Real>::submit(Request& request)
+{
+	request.done.store(false, std::memory_order_relaxed);
+	if (!queue.push(&request)) return false;
+
+	//a thread about to sleep either sees the request or is counted here
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleepers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		wake.notify_one();
+	}
+
+	return true;
+}
+
+/*******************************************************************
+* Takes up to a batch of waiting requests at a time, sleeps once the
+* queue has stayed empty for a while
+********************************************************************/
+template<typename Real>
+void BasicInferenceEngine<Real>::workerLoop()
+{
+	typename Publisher::Reader reader(*publisher);
+	NeuronBatch batch(publisher->topology(), batchSize);
+	std::vector<Request*> requests(batchSize);
+	int idle = 0;
+
+	while (true)
+	{
+		int n = 0;
+		while (n < batchSize && queue.pop(requests[n])) n++;
+
+		if (n > 0)
+		{
+			runBatch(reader.acquire().network, batch, requests.data(), n);
+			idle = 0;
+			continue;
+		}
+
+		if (stopping) return;
+		if (++idle < IDLE_SPINS)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		//do not keep an old snapshot alive while sleeping
+		reader.release();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		sleepers++;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (queue.empty() && !stopping) wake.wait(lock);
+		sleepers--;
+		idle = 0;
+	}
+}
+
+/*******************************************************************
+* Gather, one forward pass, scatter
+********************************************************************/
+template<typename Real>
+void BasicInferenceEngine<Real>::runBatch(const Network& nn, NeuronBatch& batch, Request** requests, int n) const
+{
+	MatrixView<Real> input = batch.layer(0);
+	for (int b = 0; b < n; b++) std::transform(requests[b]->pattern, requests[b]->pattern + nn.nInput, input.row(b), [](double v) { return (Real)v; });
+
+	nn.feedForwardBatch(batch, n);
+
+	MatrixView<Real> output = batch.layer(nn.numWeightLayers());
+	for (int b = 0; b < n; b++)
+	{
+		Request& r = *requests[b];
+		const Real* o = output.row(b);
+
+		if (r.outputs != nullptr) std::copy(o, o + nn.nOutput, r.outputs);
+		if (r.results != nullptr) for (int k = 0; k < nn.nOutput; k++) r.results[k] = nn.clampOutput(o[k]);
+
+		r.done.store(true, std::memory_order_release);
+	}
+}
+
+template class air::BasicInferenceEngine<float>;
+template class air::BasicInferenceEngine<double>;
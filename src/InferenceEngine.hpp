@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "NeuralNetwork.hpp"
+#include "WeightSnapshot.hpp"
+#include "LockFreeQueue.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* One agent's query: the engine reads the pattern and writes raw
+	* outputs and/or clamped results (either may be nullptr), the
+	* buffers have to stay valid until the request is done
+	********************************************************************/
+	template<typename Real>
+	struct BasicInferenceRequest
+	{
+		const double* pattern = nullptr;		//nInput values
+		Real* outputs = nullptr;				//nOutput raw outputs
+		int* results = nullptr;					//nOutput clamped 0 / 1 / -1 results
+		std::atomic<bool> done{ false };
+
+		bool ready() const { return done.load(std::memory_order_acquire); }
+		void wait() const { while (!ready()) std::this_thread::yield(); }
+	};
+
+	/*******************************************************************
+	* Batched inference for many concurrent agents. Agents push requests
+	* onto a lock-free queue; each engine thread takes whatever is
+	* waiting (up to one batch), gathers the patterns into its own
+	* neuron batch, runs one forward pass over the latest weight
+	* snapshot and scatters the outputs back. A thread never waits for
+	* a batch to fill up, so a request waits at most for the batch in
+	* flight. Snapshots published while the engine runs (e.g. by the
+	* trainer) are picked up from the next batch on.
+	********************************************************************/
+	template<typename Real>
+	class BasicInferenceEngine
+	{
+	public:
+		typedef BasicNeuralNetwork<Real> Network;
+		typedef BasicNeuronBatch<Real> NeuronBatch;
+		typedef BasicInferenceRequest<Real> Request;
+		typedef BasicSnapshotPublisher<Real> Publisher;
+
+		//numThreads = 0 starts one thread per hardware thread
+		BasicInferenceEngine(std::shared_ptr<Publisher> publisher, int numThreads = 0, int batchSize = EVALUATION_BATCH_SIZE, int queueCapacity = 4096);
+
+		//serves a fixed copy of the network
+		BasicInferenceEngine(const Network& network, int numThreads = 0, int batchSize = EVALUATION_BATCH_SIZE, int queueCapacity = 4096);
+		~BasicInferenceEngine();
+
+		//queues a request, returns false if the queue is full
+		bool submit(Request& request);
+
+		int size() const { return (int)threads.size(); }
+
+	private:
+		void workerLoop();
+		void runBatch(const Network& nn, NeuronBatch& batch, Request** requests, int n) const;
+
+	private:
+		std::shared_ptr<Publisher> publisher;
+		int batchSize;
+
+		LockFreeQueue<Request*> queue;
+		std::vector<std::thread> threads;
+
+		//idle threads sleep here until a request arrives
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::atomic<int> sleepers;
+		std::atomic<bool> stopping;
+	};
+
+	typedef BasicInferenceRequest<double> InferenceRequest;
+	typedef BasicInferenceRequest<float> InferenceRequestF;
+	typedef BasicInferenceEngine<double> InferenceEngine;
+	typedef BasicInferenceEngine<float> InferenceEngineF;
+}
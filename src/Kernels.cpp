@@ -0,0 +1,438 @@
+#include "Kernels.hpp"
+#include <math.h>
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+using namespace air;
+using namespace air::kernels;
+
+/*******************************************************************
+* Plain scalar kernels, identical in evaluation order to the original
+* loops so results are reproducible on every machine
+********************************************************************/
+namespace
+{
+	namespace scalar
+	{
+		template<typename Real>
+		void gemv(const Real* x, const Real* w, int rows, int cols, Real* y)
+		{
+			for (int j = 0; j < cols; j++) y[j] = 0;
+
+			//accumulate one weight row at a time, preserves the summation order over x
+			for (int i = 0; i < rows; i++)
+			{
+				const Real xi = x[i];
+				const Real* row = w + i * cols;
+				for (int j = 0; j < cols; j++) y[j] += xi * row[j];
+			}
+		}
+
+		template<typename Real>
+		void gemvTransposed(const Real* w, int cols, const Real* g, Real* y, int n)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				const Real* row = w + i * cols;
+				Real sum = 0;
+				for (int j = 0; j < cols; j++) sum += row[j] * g[j];
+				y[i] = sum;
+			}
+		}
+
+		template<typename Real>
+		void gemm(const Real* x, int ldx, const Real* w, int rows, int cols, Real* y, int ldy, int n)
+		{
+			for (int b = 0; b < n; b++) gemv<Real>(x + b * ldx, w, rows, cols, y + b * ldy);
+		}
+
+		template<typename Real>
+		void outerProductUpdate(Real* d, int rows, int cols, Real a, const Real* x, const Real* g, Real m)
+		{
+			for (int i = 0; i < rows; i++)
+			{
+				const Real ax = a * x[i];
+				Real* row = d + i * cols;
+				for (int j = 0; j < cols; j++) row[j] = ax * g[j] + m * row[j];
+			}
+		}
+
+		template<typename Real>
+		void outerProductAccumulate(Real* d, int rows, int cols, Real a, const Real* x, const Real* g)
+		{
+			for (int i = 0; i < rows; i++)
+			{
+				const Real ax = a * x[i];
+				Real* row = d + i * cols;
+				for (int j = 0; j < cols; j++) row[j] += ax * g[j];
+			}
+		}
+
+		template<typename Real>
+		void outerProductAccumulateBatch(Real* d, int rows, int cols, Real a, const Real* x, int ldx, const Real* g, int ldg, int n)
+		{
+			for (int i = 0; i < rows; i++)
+			{
+				Real* row = d + i * cols;
+				for (int b = 0; b < n; b++)
+				{
+					const Real ax = a * x[b * ldx + i];
+					const Real* gb = g + b * ldg;
+					for (int j = 0; j < cols; j++) row[j] += ax * gb[j];
+				}
+			}
+		}
+
+		template<typename Real>
+		void add(Real* w, const Real* d, int n)
+		{
+			for (int i = 0; i < n; i++) w[i] += d[i];
+		}
+
+		template<typename Real>
+		void addScaled(Real* d, const Real* g, Real m, int n)
+		{
+			for (int i = 0; i < n; i++) d[i] = g[i] + m * d[i];
+		}
+
+		template<typename Real>
+		void adamUpdate(Real* d, Real* m, Real* v, const Real* g, int n, Real beta1, Real beta2, Real step, Real epsilon)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				m[i] = beta1 * m[i] + (1 - beta1) * g[i];
+				v[i] = beta2 * v[i] + (1 - beta2) * g[i] * g[i];
+				d[i] = step * m[i] / (sqrt(v[i]) + epsilon);
+			}
+		}
+
+		template<typename Real>
+		void rmspropUpdate(Real* d, Real* s, const Real* g, int n, Real rho, Real rate, Real epsilon)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				s[i] = rho * s[i] + (1 - rho) * g[i] * g[i];
+				d[i] = rate * g[i] / (sqrt(s[i]) + epsilon);
+			}
+		}
+
+		template<typename Real>
+		void nesterovUpdate(Real* d, Real* v, const Real* g, int n, Real rate, Real momentum)
+		{
+			for (int i = 0; i < n; i++)
+			{
+				v[i] = momentum * v[i] + rate * g[i];
+				d[i] = momentum * v[i] + rate * g[i];
+			}
+		}
+
+		template<typename Real>
+		void sigmoid(Real* x, int n)
+		{
+			for (int i = 0; i < n; i++) x[i] = 1 / (1 + exp(-x[i]));
+		}
+
+		void gemvInt8(const std::int8_t* x, const std::int8_t* w, int rows, int cols, std::int32_t* y)
+		{
+			for (int j = 0; j < cols; j++) y[j] = 0;
+
+			for (int i = 0; i < rows; i += 2)
+			{
+				std::int32_t x0 = x[i], x1 = x[i + 1];
+				const std::int8_t* row = w + i * cols;
+				for (int j = 0; j < cols; j++) y[j] += x0 * row[2 * j] + x1 * row[2 * j + 1];
+			}
+		}
+
+		//sigmoid sampled every 1 / SIGMOID_TABLE_RESOLUTION over +-SIGMOID_TABLE_RANGE,
+		//interpolation error stays below 3e-6 and the clamped tails below 1.2e-7
+		const int SIGMOID_TABLE_RESOLUTION = 64;
+		const int SIGMOID_TABLE_RANGE = 16;
+		const int SIGMOID_TABLE_SIZE = 2 * SIGMOID_TABLE_RANGE * SIGMOID_TABLE_RESOLUTION + 2;
+
+		template<typename Real>
+		struct SigmoidTable
+		{
+			SigmoidTable()
+			{
+				for (int i = 0; i < SIGMOID_TABLE_SIZE; i++) values[i] = (Real)(1 / (1 + exp(SIGMOID_TABLE_RANGE - (double)i / SIGMOID_TABLE_RESOLUTION)));
+			}
+
+			Real values[SIGMOID_TABLE_SIZE];
+		};
+
+		template<typename Real>
+		void sigmoidFast(Real* x, int n)
+		{
+			static const SigmoidTable<Real> table;
+			const Real last = SIGMOID_TABLE_SIZE - 2;
+
+			for (int i = 0; i < n; i++)
+			{
+				//position in the table, clamped to its ends
+				Real t = (x[i] + SIGMOID_TABLE_RANGE) * SIGMOID_TABLE_RESOLUTION;
+				t = t > 0 ? (t < last ? t : last) : 0;
+
+				int k = (int)t;
+				Real f = t - k;
+				x[i] = table.values[k] + f * (table.values[k + 1] - table.values[k]);
+			}
+		}
+
+		template<typename Real>
+		void sigmoidDerivative(const Real* y, Real* g, int n)
+		{
+			for (int i = 0; i < n; i++) g[i] = y[i] * (1 - y[i]) * g[i];
+		}
+
+		/*******************************************************************
+		* Activation policies, see KernelsImpl.hpp
+		********************************************************************/
+		template<typename Real>
+		struct SigmoidActivation
+		{
+			static void apply(Real* x, int n) { sigmoid(x, n); }
+			static void derivative(const Real* y, Real* g, int n) { sigmoidDerivative(y, g, n); }
+		};
+
+		template<typename Real>
+		struct TanhActivation
+		{
+			static void apply(Real* x, int n)
+			{
+				for (int i = 0; i < n; i++) x[i] = tanh(x[i]);
+			}
+
+			static void derivative(const Real* y, Real* g, int n)
+			{
+				for (int i = 0; i < n; i++) g[i] = (1 - y[i] * y[i]) * g[i];
+			}
+		};
+
+		template<typename Real>
+		struct ReluActivation
+		{
+			static void apply(Real* x, int n)
+			{
+				for (int i = 0; i < n; i++) x[i] = x[i] > 0 ? x[i] : 0;
+			}
+
+			static void derivative(const Real* y, Real* g, int n)
+			{
+				for (int i = 0; i < n; i++) g[i] = y[i] > 0 ? g[i] : 0;
+			}
+		};
+
+		template<typename Real>
+		struct LeakyReluActivation
+		{
+			static void apply(Real* x, int n)
+			{
+				for (int i = 0; i < n; i++) x[i] = x[i] > 0 ? x[i] : Real(LEAKY_RELU_SLOPE) * x[i];
+			}
+
+			static void derivative(const Real* y, Real* g, int n)
+			{
+				for (int i = 0; i < n; i++) g[i] = y[i] > 0 ? g[i] : Real(LEAKY_RELU_SLOPE) * g[i];
+			}
+		};
+
+		template<typename Real>
+		struct SoftmaxActivation
+		{
+			static void apply(Real* x, int n)
+			{
+				//shifting by the largest value keeps e^x finite
+				Real largest = *std::max_element(x, x + n);
+
+				Real total = 0;
+				for (int i = 0; i < n; i++)
+				{
+					x[i] = exp(x[i] - largest);
+					total += x[i];
+				}
+				for (int i = 0; i < n; i++) x[i] /= total;
+			}
+
+			static void derivative(const Real* y, Real* g, int n)
+			{
+				Real total = 0;
+				for (int i = 0; i < n; i++) total += y[i] * g[i];
+				for (int i = 0; i < n; i++) g[i] = y[i] * (g[i] - total);
+			}
+		};
+	}
+
+	/*******************************************************************
+	* CPU feature checks
+	********************************************************************/
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	bool cpuSupports(Isa isa)
+	{
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		bool sse2 = (info[3] & (1 << 26)) != 0;
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+
+		bool avx2 = false, avx512 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+			avx512 = (info[1] & (1 << 16)) != 0;
+		}
+
+		//the OS has to save the ymm / zmm registers too
+		bool ymmState = (xcr0 & 0x6) == 0x6;
+		bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+		switch (isa)
+		{
+			case Isa::SSE2: return sse2;
+			case Isa::AVX2: return avx2 && fma && ymmState;
+			case Isa::AVX512: return avx512 && zmmState;
+			default: return true;
+		}
+	}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	bool cpuSupports(Isa isa)
+	{
+		__builtin_cpu_init();
+		switch (isa)
+		{
+			case Isa::SSE2: return __builtin_cpu_supports("sse2");
+			case Isa::AVX2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			case Isa::AVX512: return __builtin_cpu_supports("avx512f");
+			default: return true;
+		}
+	}
+#else
+	bool cpuSupports(Isa isa)
+	{
+		return isa == Isa::Scalar;
+	}
+#endif
+
+	/*******************************************************************
+	* Kernel table for an instruction set, nullptr if not available
+	********************************************************************/
+	template<typename Real>
+	const KernelTable<Real>* tableFor(Isa isa)
+	{
+		if (!cpuSupports(isa)) return nullptr;
+
+		switch (isa)
+		{
+			case Isa::SSE2: return sse2Kernels<Real>();
+			case Isa::AVX2: return avx2Kernels<Real>();
+			case Isa::AVX512: return avx512Kernels<Real>();
+			default: return scalarKernels<Real>();
+		}
+	}
+
+	template<typename Real>
+	const KernelTable<Real>*& activeTable()
+	{
+		static const KernelTable<Real>* active = tableFor<Real>(detectIsa());
+		return active;
+	}
+
+	template<typename Policy, typename Real>
+	void setActivation(KernelTable<Real>& t, Activation a)
+	{
+		t.activate[(int)a] = &Policy::apply;
+		t.activationDerivative[(int)a] = &Policy::derivative;
+	}
+
+	template<typename Real>
+	KernelTable<Real> scalarTable()
+	{
+		KernelTable<Real> t = {};
+		t.isa = Isa::Scalar;
+		t.name = "Scalar";
+		t.gemv = &scalar::gemv<Real>;
+		t.gemvTransposed = &scalar::gemvTransposed<Real>;
+		t.gemm = &scalar::gemm<Real>;
+		t.outerProductUpdate = &scalar::outerProductUpdate<Real>;
+		t.outerProductAccumulate = &scalar::outerProductAccumulate<Real>;
+		t.outerProductAccumulateBatch = &scalar::outerProductAccumulateBatch<Real>;
+		t.add = &scalar::add<Real>;
+		t.addScaled = &scalar::addScaled<Real>;
+		t.adamUpdate = &scalar::adamUpdate<Real>;
+		t.rmspropUpdate = &scalar::rmspropUpdate<Real>;
+		t.nesterovUpdate = &scalar::nesterovUpdate<Real>;
+		t.sigmoid = &scalar::sigmoid<Real>;
+		t.sigmoidFast = &scalar::sigmoidFast<Real>;
+		t.sigmoidDerivative = &scalar::sigmoidDerivative<Real>;
+		t.gemvInt8 = &scalar::gemvInt8;
+		setActivation<scalar::SigmoidActivation<Real>>(t, Activation::Sigmoid);
+		setActivation<scalar::TanhActivation<Real>>(t, Activation::Tanh);
+		setActivation<scalar::ReluActivation<Real>>(t, Activation::ReLU);
+		setActivation<scalar::LeakyReluActivation<Real>>(t, Activation::LeakyReLU);
+		setActivation<scalar::SoftmaxActivation<Real>>(t, Activation::Softmax);
+		return t;
+	}
+}
+
+template<>
+const KernelTable<double>* kernels::scalarKernels<double>()
+{
+	static const KernelTable<double> t = scalarTable<double>();
+	return &t;
+}
+
+template<>
+const KernelTable<float>* kernels::scalarKernels<float>()
+{
+	static const KernelTable<float> t = scalarTable<float>();
+	return &t;
+}
+
+/*******************************************************************
+* Best instruction set supported by both the CPU and this build
+********************************************************************/
+Isa kernels::detectIsa()
+{
+	const Isa candidates[] = { Isa::AVX512, Isa::AVX2, Isa::SSE2 };
+	for (Isa isa : candidates)
+	{
+		if (tableFor<double>(isa) != nullptr) return isa;
+	}
+	return Isa::Scalar;
+}
+
+template<>
+const KernelTable<double>& kernels::table<double>()
+{
+	return *activeTable<double>();
+}
+
+template<>
+const KernelTable<float>& kernels::table<float>()
+{
+	return *activeTable<float>();
+}
+
+/*******************************************************************
+* Force an instruction set for both element types, fails if the CPU
+* or build lacks it
+********************************************************************/
+bool kernels::selectIsa(Isa isa)
+{
+	const KernelTable<double>* d = tableFor<double>(isa);
+	const KernelTable<float>* f = tableFor<float>(isa);
+	if (d == nullptr || f == nullptr) return false;
+
+	activeTable<double>() = d;
+	activeTable<float>() = f;
+	return true;
+}
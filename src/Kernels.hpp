@@ -0,0 +1,277 @@
+#pragma once
+#include <cstdint>
+#include "Matrix.hpp"
+
+/*******************************************************************
+* Dense kernels used by the forward and backward passes. Weight
+* matrices are stored row-major as [source neuron][target neuron],
+* so every inner loop walks one contiguous row.
+*
+* Each kernel exists once per instruction set (scalar, SSE2, AVX2,
+* AVX-512) and element type (float, double), the best instruction
+* set supported by the CPU is picked at startup.
+********************************************************************/
+namespace air
+{
+	//activation function of a neuron layer, Softmax only for the output layer
+	enum class Activation { Sigmoid, Tanh, ReLU, LeakyReLU, Softmax };
+	const int NUM_ACTIVATIONS = 5;
+
+	//slope of LeakyReLU for negative inputs
+	const double LEAKY_RELU_SLOPE = 0.01;
+
+	namespace kernels
+	{
+		enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+		/*******************************************************************
+		* Kernel implementations of one instruction set. Arguments are raw
+		* row-major buffers so the per-ISA translation units stay free of
+		* shared inline code.
+		********************************************************************/
+		template<typename Real>
+		struct KernelTable
+		{
+			Isa isa;
+			const char* name;
+			void(*gemv)(const Real* x, const Real* w, int rows, int cols, Real* y);
+			void(*gemvTransposed)(const Real* w, int cols, const Real* g, Real* y, int n);
+			void(*gemm)(const Real* x, int ldx, const Real* w, int rows, int cols, Real* y, int ldy, int n);
+			void(*outerProductUpdate)(Real* d, int rows, int cols, Real a, const Real* x, const Real* g, Real m);
+			void(*outerProductAccumulate)(Real* d, int rows, int cols, Real a, const Real* x, const Real* g);
+			void(*outerProductAccumulateBatch)(Real* d, int rows, int cols, Real a, const Real* x, int ldx, const Real* g, int ldg, int n);
+			void(*add)(Real* w, const Real* d, int n);
+			void(*addScaled)(Real* d, const Real* g, Real m, int n);
+			void(*adamUpdate)(Real* d, Real* m, Real* v, const Real* g, int n, Real beta1, Real beta2, Real step, Real epsilon);
+			void(*rmspropUpdate)(Real* d, Real* s, const Real* g, int n, Real rho, Real rate, Real epsilon);
+			void(*nesterovUpdate)(Real* d, Real* v, const Real* g, int n, Real rate, Real momentum);
+			void(*sigmoid)(Real* x, int n);
+			void(*sigmoidFast)(Real* x, int n);
+			void(*sigmoidDerivative)(const Real* y, Real* g, int n);
+
+			//integer kernels, the same in both element type tables
+			void(*gemvInt8)(const std::int8_t* x, const std::int8_t* w, int rows, int cols, std::int32_t* y);
+
+			//every activation policy, indexed by Activation
+			void(*activate[NUM_ACTIVATIONS])(Real* x, int n);
+			void(*activationDerivative[NUM_ACTIVATIONS])(const Real* y, Real* g, int n);
+		};
+
+		//tables of the per instruction set translation units, nullptr if not compiled in
+		template<typename Real> const KernelTable<Real>* scalarKernels();
+		template<typename Real> const KernelTable<Real>* sse2Kernels();
+		template<typename Real> const KernelTable<Real>* avx2Kernels();
+		template<typename Real> const KernelTable<Real>* avx512Kernels();
+
+		template<> const KernelTable<float>* scalarKernels<float>();
+		template<> const KernelTable<double>* scalarKernels<double>();
+		template<> const KernelTable<float>* sse2Kernels<float>();
+		template<> const KernelTable<double>* sse2Kernels<double>();
+		template<> const KernelTable<float>* avx2Kernels<float>();
+		template<> const KernelTable<double>* avx2Kernels<double>();
+		template<> const KernelTable<float>* avx512Kernels<float>();
+		template<> const KernelTable<double>* avx512Kernels<double>();
+
+		//best instruction set supported by this CPU (and this build)
+		Isa detectIsa();
+
+		//kernels in use, defaults to detectIsa()
+		template<typename Real> const KernelTable<Real>& table();
+		template<> const KernelTable<float>& table<float>();
+		template<> const KernelTable<double>& table<double>();
+
+		//force an instruction set (e.g. Scalar for reproducible results), returns false if unsupported
+		bool selectIsa(Isa isa);
+
+		//read-only views and scalars do not take part in deducing the element type
+		template<typename Real> using ConstView = typename NonDeduced<MatrixView<const Real>>::type;
+		template<typename Real> using Scalar = typename NonDeduced<Real>::type;
+
+		/*******************************************************************
+		* y = x * W (x has W.rows entries, y has W.cols entries)
+		********************************************************************/
+		template<typename Real>
+		inline void gemv(const Real* x, ConstView<Real> w, Real* y)
+		{
+			table<Real>().gemv(x, w.data, w.rows, w.cols, y);
+		}
+
+		/*******************************************************************
+		* y = W * g for the first n rows of W (g has W.cols entries)
+		********************************************************************/
+		template<typename Real>
+		inline void gemvTransposed(ConstView<Real> w, const Real* g, Real* y, int n)
+		{
+			table<Real>().gemvTransposed(w.data, w.cols, g, y, n);
+		}
+
+		/*******************************************************************
+		* d = a * x * g^T + m * d (stochastic delta with momentum)
+		********************************************************************/
+		template<typename Real>
+		inline void outerProductUpdate(MatrixView<Real> d, Scalar<Real> a, const Real* x, const Real* g, Scalar<Real> m)
+		{
+			table<Real>().outerProductUpdate(d.data, d.rows, d.cols, a, x, g, m);
+		}
+
+		/*******************************************************************
+		* d += a * x * g^T (batch delta accumulation)
+		********************************************************************/
+		template<typename Real>
+		inline void outerProductAccumulate(MatrixView<Real> d, Scalar<Real> a, const Real* x, const Real* g)
+		{
+			table<Real>().outerProductAccumulate(d.data, d.rows, d.cols, a, x, g);
+		}
+
+		/*******************************************************************
+		* w += d over n contiguous values
+		********************************************************************/
+		template<typename Real>
+		inline void add(Real* w, const Real* d, int n)
+		{
+			table<Real>().add(w, d, n);
+		}
+
+		/*******************************************************************
+		* Y = X * W for the first n rows of X, writes the first W.cols
+		* columns of every row of Y (the remaining bias column is kept)
+		********************************************************************/
+		template<typename Real>
+		inline void gemm(ConstView<Real> x, ConstView<Real> w, MatrixView<Real> y, int n)
+		{
+			table<Real>().gemm(x.data, x.cols, w.data, w.rows, w.cols, y.data, y.cols, n);
+		}
+
+		/*******************************************************************
+		* Y = G * W^T for the first n rows of G, writes the first m columns
+		* of every row of Y
+		********************************************************************/
+		template<typename Real>
+		inline void gemmTransposed(ConstView<Real> g, ConstView<Real> w, MatrixView<Real> y, int n, int m)
+		{
+			const KernelTable<Real>& k = table<Real>();
+			for (int b = 0; b < n; b++) k.gemvTransposed(w.data, w.cols, g.row(b), y.row(b), m);
+		}
+
+		/*******************************************************************
+		* d += a * X^T * G over the first n rows of X and G
+		********************************************************************/
+		template<typename Real>
+		inline void outerProductAccumulateBatch(MatrixView<Real> d, Scalar<Real> a, ConstView<Real> x, ConstView<Real> g, int n)
+		{
+			table<Real>().outerProductAccumulateBatch(d.data, d.rows, d.cols, a, x.data, x.cols, g.data, g.cols, n);
+		}
+
+		/*******************************************************************
+		* d = g + m * d over n contiguous values
+		********************************************************************/
+		template<typename Real>
+		inline void addScaled(Real* d, const Real* g, Scalar<Real> m, int n)
+		{
+			table<Real>().addScaled(d, g, m, n);
+		}
+
+		/*******************************************************************
+		* Adam over n contiguous weights, g is the descent direction:
+		* m = beta1 * m + (1 - beta1) * g, v = beta2 * v + (1 - beta2) * g^2,
+		* d = step * m / (sqrt(v) + epsilon) - step includes the bias
+		* correction of the current time step
+		********************************************************************/
+		template<typename Real>
+		inline void adamUpdate(Real* d, Real* m, Real* v, const Real* g, int n, Scalar<Real> beta1, Scalar<Real> beta2, Scalar<Real> step, Scalar<Real> epsilon)
+		{
+			table<Real>().adamUpdate(d, m, v, g, n, beta1, beta2, step, epsilon);
+		}
+
+		/*******************************************************************
+		* RMSProp over n contiguous weights: s = rho * s + (1 - rho) * g^2,
+		* d = rate * g / (sqrt(s) + epsilon)
+		********************************************************************/
+		template<typename Real>
+		inline void rmspropUpdate(Real* d, Real* s, const Real* g, int n, Scalar<Real> rho, Scalar<Real> rate, Scalar<Real> epsilon)
+		{
+			table<Real>().rmspropUpdate(d, s, g, n, rho, rate, epsilon);
+		}
+
+		/*******************************************************************
+		* Nesterov momentum over n contiguous weights, with the velocity
+		* kept at the look-ahead point: v = momentum * v + rate * g,
+		* d = momentum * v + rate * g
+		********************************************************************/
+		template<typename Real>
+		inline void nesterovUpdate(Real* d, Real* v, const Real* g, int n, Scalar<Real> rate, Scalar<Real> momentum)
+		{
+			table<Real>().nesterovUpdate(d, v, g, n, rate, momentum);
+		}
+
+		/*******************************************************************
+		* x = 1 / (1 + e^-x) over n contiguous values
+		********************************************************************/
+		template<typename Real>
+		inline void sigmoid(Real* x, int n)
+		{
+			table<Real>().sigmoid(x, n);
+		}
+
+		/*******************************************************************
+		* Approximate sigmoid, |error| below SIGMOID_FAST_MAX_ERROR on every
+		* instruction set (interpolated table for Scalar, a shorter exp
+		* polynomial for SIMD)
+		********************************************************************/
+		const double SIGMOID_FAST_MAX_ERROR = 2e-5;
+
+		template<typename Real>
+		inline void sigmoidFast(Real* x, int n)
+		{
+			table<Real>().sigmoidFast(x, n);
+		}
+
+		/*******************************************************************
+		* g = y * (1 - y) * g over n contiguous values (y = sigmoid output)
+		********************************************************************/
+		template<typename Real>
+		inline void sigmoidDerivative(const Real* y, Real* g, int n)
+		{
+			table<Real>().sigmoidDerivative(y, g, n);
+		}
+
+		/*******************************************************************
+		* y = x * W in 32 bit integers. rows must be even (pad x and W with
+		* a zero row), W is laid out by packedInt8Index.
+		********************************************************************/
+		inline void gemvInt8(const std::int8_t* x, const std::int8_t* w, int rows, int cols, std::int32_t* y)
+		{
+			table<float>().gemvInt8(x, w, rows, cols, y);
+		}
+
+		/*******************************************************************
+		* Index of element (i, j) of a rows x cols int8 matrix packed for
+		* gemvInt8: pairs of rows are interleaved so every 16 bit multiply
+		* add pairs two rows of one column
+		********************************************************************/
+		inline int packedInt8Index(int i, int j, int cols)
+		{
+			return ((i / 2) * cols + j) * 2 + i % 2;
+		}
+
+		/*******************************************************************
+		* x = f(x) over n contiguous values (one layer, Softmax normalises
+		* over all n)
+		********************************************************************/
+		template<typename Real>
+		inline void activate(Activation a, Real* x, int n)
+		{
+			table<Real>().activate[(int)a](x, n);
+		}
+
+		/*******************************************************************
+		* g = f'(x) * g over n contiguous values given y = f(x), for Softmax
+		* the product with its Jacobian
+		********************************************************************/
+		template<typename Real>
+		inline void activationDerivative(Activation a, const Real* y, Real* g, int n)
+		{
+			table<Real>().activationDerivative[(int)a](y, g, n);
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#include "KernelsImpl.hpp"
+
+//built with AVX2 + FMA code generation (see CMakeLists.txt), only called after a CPU check
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+
+namespace air
+{
+	namespace kernels
+	{
+		namespace
+		{
+			struct Avx2
+			{
+				typedef double scalar;
+				typedef __m256d type;
+				static const int width = 4;
+
+				static type load(const double* p) { return _mm256_loadu_pd(p); }
+				static void store(double* p, type v) { _mm256_storeu_pd(p, v); }
+				static type set1(double d) { return _mm256_set1_pd(d); }
+				static type zero() { return _mm256_setzero_pd(); }
+				static type add(type a, type b) { return _mm256_add_pd(a, b); }
+				static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+				static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+				static type div(type a, type b) { return _mm256_div_pd(a, b); }
+				static type min(type a, type b) { return _mm256_min_pd(a, b); }
+				static type max(type a, type b) { return _mm256_max_pd(a, b); }
+				static type sqrt(type a) { return _mm256_sqrt_pd(a); }
+				static type fmadd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+				static double hsum(type v)
+				{
+					__m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+					return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+				}
+				static type shiftExponent(type v) { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(v), 52)); }
+			};
+
+			struct Avx2F
+			{
+				typedef float scalar;
+				typedef __m256 type;
+				static const int width = 8;
+
+				static type load(const float* p) { return _mm256_loadu_ps(p); }
+				static void store(float* p, type v) { _mm256_storeu_ps(p, v); }
+				static type set1(float d) { return _mm256_set1_ps(d); }
+				static type zero() { return _mm256_setzero_ps(); }
+				static type add(type a, type b) { return _mm256_add_ps(a, b); }
+				static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+				static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+				static type div(type a, type b) { return _mm256_div_ps(a, b); }
+				static type min(type a, type b) { return _mm256_min_ps(a, b); }
+				static type max(type a, type b) { return _mm256_max_ps(a, b); }
+				static type sqrt(type a) { return _mm256_sqrt_ps(a); }
+				static type fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+				static float hsum(type v)
+				{
+					__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+					s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+					return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+				}
+				static type shiftExponent(type v) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_castps_si256(v), 23)); }
+			};
+
+			struct Avx2I
+			{
+				typedef __m256i type;
+				static const int width = 8;
+
+				static type loadWidened(const std::int8_t* p) { return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)p)); }
+				static void store(std::int32_t* p, type v) { _mm256_storeu_si256((__m256i*)p, v); }
+				static type set1(std::int32_t d) { return _mm256_set1_epi32(d); }
+				static type zero() { return _mm256_setzero_si256(); }
+				static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+				static type madd(type a, type b) { return _mm256_madd_epi16(a, b); }
+			};
+		}
+
+		template<>
+		const KernelTable<double>* avx2Kernels<double>()
+		{
+			static const KernelTable<double> t = SimdKernels<Avx2, Avx2I>::table(Isa::AVX2, "AVX2");
+			return &t;
+		}
+
+		template<>
+		const KernelTable<float>* avx2Kernels<float>()
+		{
+			static const KernelTable<float> t = SimdKernels<Avx2F, Avx2I>::table(Isa::AVX2, "AVX2");
+			return &t;
+		}
+	}
+}
+#else
+template<> const air::kernels::KernelTable<double>* air::kernels::avx2Kernels<double>() { return nullptr; }
+template<> const air::kernels::KernelTable<float>* air::kernels::avx2Kernels<float>() { return nullptr; }
+#endif
@@ -0,0 +1,90 @@
+#include "KernelsImpl.hpp"
+
+//built with AVX-512F code generation (see CMakeLists.txt), only called after a CPU check
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace air
+{
+	namespace kernels
+	{
+		namespace
+		{
+			struct Avx512
+			{
+				typedef double scalar;
+				typedef __m512d type;
+				static const int width = 8;
+
+				static type load(const double* p) { return _mm512_loadu_pd(p); }
+				static void store(double* p, type v) { _mm512_storeu_pd(p, v); }
+				static type set1(double d) { return _mm512_set1_pd(d); }
+				static type zero() { return _mm512_setzero_pd(); }
+				static type add(type a, type b) { return _mm512_add_pd(a, b); }
+				static type sub(type a, type b) { return _mm512_sub_pd(a, b); }
+				static type mul(type a, type b) { return _mm512_mul_pd(a, b); }
+				static type div(type a, type b) { return _mm512_div_pd(a, b); }
+				static type min(type a, type b) { return _mm512_min_pd(a, b); }
+				static type max(type a, type b) { return _mm512_max_pd(a, b); }
+				static type sqrt(type a) { return _mm512_sqrt_pd(a); }
+				static type fmadd(type a, type b, type c) { return _mm512_fmadd_pd(a, b, c); }
+				static double hsum(type v) { return _mm512_reduce_add_pd(v); }
+				static type shiftExponent(type v) { return _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(v), 52)); }
+			};
+
+			struct Avx512F
+			{
+				typedef float scalar;
+				typedef __m512 type;
+				static const int width = 16;
+
+				static type load(const float* p) { return _mm512_loadu_ps(p); }
+				static void store(float* p, type v) { _mm512_storeu_ps(p, v); }
+				static type set1(float d) { return _mm512_set1_ps(d); }
+				static type zero() { return _mm512_setzero_ps(); }
+				static type add(type a, type b) { return _mm512_add_ps(a, b); }
+				static type sub(type a, type b) { return _mm512_sub_ps(a, b); }
+				static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+				static type div(type a, type b) { return _mm512_div_ps(a, b); }
+				static type min(type a, type b) { return _mm512_min_ps(a, b); }
+				static type max(type a, type b) { return _mm512_max_ps(a, b); }
+				static type sqrt(type a) { return _mm512_sqrt_ps(a); }
+				static type fmadd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+				static float hsum(type v) { return _mm512_reduce_add_ps(v); }
+				static type shiftExponent(type v) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_castps_si512(v), 23)); }
+			};
+
+			//AVX-512F has no 16 bit integer multiply add (that needs AVX-512BW), use the AVX2 one
+			struct Avx512I
+			{
+				typedef __m256i type;
+				static const int width = 8;
+
+				static type loadWidened(const std::int8_t* p) { return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)p)); }
+				static void store(std::int32_t* p, type v) { _mm256_storeu_si256((__m256i*)p, v); }
+				static type set1(std::int32_t d) { return _mm256_set1_epi32(d); }
+				static type zero() { return _mm256_setzero_si256(); }
+				static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+				static type madd(type a, type b) { return _mm256_madd_epi16(a, b); }
+			};
+		}
+
+		template<>
+		const KernelTable<double>* avx512Kernels<double>()
+		{
+			static const KernelTable<double> t = SimdKernels<Avx512, Avx512I>::table(Isa::AVX512, "AVX-512");
+			return &t;
+		}
+
+		template<>
+		const KernelTable<float>* avx512Kernels<float>()
+		{
+			static const KernelTable<float> t = SimdKernels<Avx512F, Avx512I>::table(Isa::AVX512, "AVX-512");
+			return &t;
+		}
+	}
+}
+#else
+template<> const air::kernels::KernelTable<double>* air::kernels::avx512Kernels<double>() { return nullptr; }
+template<> const air::kernels::KernelTable<float>* air::kernels::avx512Kernels<float>() { return nullptr; }
+#endif
@@ -0,0 +1,619 @@
+#pragma once
+#include <cstring>
+#include <math.h>
+#include <cstdint>
+#include <type_traits>
+#include "Kernels.hpp"
+
+/*******************************************************************
+* Kernel bodies shared by all SIMD instruction sets. Only included
+* by the KernelsXXX.cpp files, each of which is compiled for one
+* instruction set and instantiates these templates with its own
+* vector type V. Everything lives in an unnamed namespace so no code
+* built with wider instructions can leak into other translation units.
+*
+* V provides: scalar (element type), type, width, load, store, set1,
+* zero, add, sub, mul, div, min, max, sqrt, fmadd (a * b + c), hsum
+* and shiftExponent (integer shift of every lane by the mantissa
+* width).
+*
+* IV (32 bit integer lanes) provides: type, width, loadWidened (2 *
+* width bytes sign extended to 16 bit), store, set1, zero, add and
+* madd (16 bit products, adjacent pairs summed into 32 bit lanes).
+********************************************************************/
+namespace air
+{
+	namespace kernels
+	{
+		namespace
+		{
+			//sqrt of the C library - std::sqrt(float) is an inline function, each of these files would emit
+			//a copy built for its own instruction set and the linker keeps just one of them for all callers
+			inline float scalarSqrt(float a) { return sqrtf(a); }
+			inline double scalarSqrt(double a) { return sqrt(a); }
+
+			/*******************************************************************
+			* Constants of the vectorised exp per element type
+			********************************************************************/
+			template<typename Real>
+			struct ExpTraits;
+
+			template<>
+			struct ExpTraits<double>
+			{
+				static const int mantissaBits = 52;
+				static const int degree = 12;
+				static const int fastDegree = 4;
+				static double maxInput() { return 708.0; }
+				static double roundShifter() { return 6755399441055744.0; }		//1.5 * 2^52
+				static double exponentShifter() { return 4503599627371519.0; }	//2^52 + 1023
+				static double ln2High() { return 6.93145751953125e-1; }
+				static double ln2Low() { return 1.42860682030941723212e-6; }
+				static double coefficient(int i)
+				{
+					static const double c[] = { 1.0, 1.0, 1.0 / 2, 1.0 / 6, 1.0 / 24, 1.0 / 120, 1.0 / 720, 1.0 / 5040, 1.0 / 40320,
+						1.0 / 362880, 1.0 / 3628800, 1.0 / 39916800, 1.0 / 479001600 };
+					return c[i];
+				}
+			};
+
+			template<>
+			struct ExpTraits<float>
+			{
+				static const int mantissaBits = 23;
+				static const int degree = 7;
+				static const int fastDegree = 4;
+				static float maxInput() { return 87.0f; }
+				static float roundShifter() { return 12582912.0f; }				//1.5 * 2^23
+				static float exponentShifter() { return 8388735.0f; }			//2^23 + 127
+				static float ln2High() { return 0.693359375f; }
+				static float ln2Low() { return -2.12194440e-4f; }
+				static float coefficient(int i)
+				{
+					static const float c[] = { 1.0f, 1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120, 1.0f / 720, 1.0f / 5040 };
+					return c[i];
+				}
+			};
+
+			/*******************************************************************
+			* Single lane fallback used for the tails of every loop
+			********************************************************************/
+			template<typename Real>
+			struct ScalarLane
+			{
+				typedef Real scalar;
+				typedef Real type;
+				static const int width = 1;
+
+				static type load(const Real* p) { return *p; }
+				static void store(Real* p, type v) { *p = v; }
+				static type set1(Real d) { return d; }
+				static type zero() { return 0; }
+				static type add(type a, type b) { return a + b; }
+				static type sub(type a, type b) { return a - b; }
+				static type mul(type a, type b) { return a * b; }
+				static type div(type a, type b) { return a / b; }
+				static type min(type a, type b) { return a < b ? a : b; }
+				static type max(type a, type b) { return a > b ? a : b; }
+				static type sqrt(type a) { return scalarSqrt(a); }
+				static type fmadd(type a, type b, type c) { return a * b + c; }
+				static Real hsum(type v) { return v; }
+				static type shiftExponent(type v)
+				{
+					//same size unsigned integer as Real
+					typedef typename std::conditional<sizeof(Real) == 8, std::uint64_t, std::uint32_t>::type Bits;
+
+					Bits bits;
+					std::memcpy(&bits, &v, sizeof(bits));
+					bits <<= ExpTraits<Real>::mantissaBits;
+					std::memcpy(&v, &bits, sizeof(bits));
+					return v;
+				}
+			};
+
+			/*******************************************************************
+			* e^x, |relative error| below a few ulp for x within +-maxInput
+			* (clamped outside). A lower Degree trades precision for speed,
+			* fastDegree stays below 6e-5.
+			********************************************************************/
+			template<typename V, int Degree = ExpTraits<typename V::scalar>::degree>
+			inline typename V::type expApprox(typename V::type x)
+			{
+				typedef typename V::type T;
+				typedef typename V::scalar Real;
+				typedef ExpTraits<Real> E;
+
+				x = V::min(V::max(x, V::set1(-E::maxInput())), V::set1(E::maxInput()));
+
+				//k = round(x / ln2), adding 1.5 * 2^mantissaBits rounds to an integer
+				const T shifter = V::set1(E::roundShifter());
+				T k = V::sub(V::fmadd(x, V::set1(Real(1.4426950408889634)), shifter), shifter);
+
+				//r = x - k * ln2, ln2 split in two parts to keep precision
+				T r = V::fmadd(k, V::set1(-E::ln2High()), x);
+				r = V::fmadd(k, V::set1(-E::ln2Low()), r);
+
+				//e^r for |r| <= ln2 / 2 with a Taylor polynomial (Horner scheme)
+				T p = V::set1(E::coefficient(Degree));
+				for (int i = Degree - 1; i >= 0; i--) p = V::fmadd(p, r, V::set1(E::coefficient(i)));
+
+				//2^k: k + bias in the low mantissa bits of (k + bias + 2^mantissaBits), moved into the exponent
+				T scale = V::shiftExponent(V::add(k, V::set1(E::exponentShifter())));
+
+				return V::mul(p, scale);
+			}
+
+			/*******************************************************************
+			* Activation policies: apply computes f over n values in place,
+			* derivative multiplies n gradients by f' given the outputs y.
+			* Every kernel table instantiates each of them, so a layer calls
+			* one fully specialised loop.
+			********************************************************************/
+			template<typename V>
+			struct SigmoidActivation
+			{
+				typedef typename V::scalar Real;
+				typedef typename V::type T;
+
+				static void apply(Real* x, int n)
+				{
+					int j = 0;
+					T one = V::set1(Real(1));
+					for (; j + V::width <= n; j += V::width)
+					{
+						T e = expApprox<V>(V::sub(V::zero(), V::load(x + j)));
+						V::store(x + j, V::div(one, V::add(one, e)));
+					}
+
+					//same approximation for the tail so results do not depend on the position
+					for (; j < n; j++) x[j] = 1 / (1 + expApprox<ScalarLane<Real>>(-x[j]));
+				}
+
+				static void derivative(const Real* y, Real* g, int n)
+				{
+					int j = 0;
+					T one = V::set1(Real(1));
+					for (; j + V::width <= n; j += V::width)
+					{
+						T yv = V::load(y + j);
+						V::store(g + j, V::mul(V::mul(yv, V::sub(one, yv)), V::load(g + j)));
+					}
+					for (; j < n; j++) g[j] = y[j] * (1 - y[j]) * g[j];
+				}
+			};
+
+			template<typename V>
+			struct TanhActivation
+			{
+				typedef typename V::scalar Real;
+				typedef typename V::type T;
+
+				//tanh(x) = 2 / (1 + e^-2x) - 1
+				static void apply(Real* x, int n)
+				{
+					int j = 0;
+					T one = V::set1(Real(1)), two = V::set1(Real(2)), minusTwo = V::set1(Real(-2));
+					for (; j + V::width <= n; j += V::width)
+					{
+						T e = expApprox<V>(V::mul(minusTwo, V::load(x + j)));
+						V::store(x + j, V::sub(V::div(two, V::add(one, e)), one));
+					}
+					for (; j < n; j++) x[j] = 2 / (1 + expApprox<ScalarLane<Real>>(-2 * x[j])) - 1;
+				}
+
+				static void derivative(const Real* y, Real* g, int n)
+				{
+					int j = 0;
+					T one = V::set1(Real(1));
+					for (; j + V::width <= n; j += V::width)
+					{
+						T yv = V::load(y + j);
+						V::store(g + j, V::mul(V::sub(one, V::mul(yv, yv)), V::load(g + j)));
+					}
+					for (; j < n; j++) g[j] = (1 - y[j] * y[j]) * g[j];
+				}
+			};
+
+			template<typename V>
+			struct ReluActivation
+			{
+				typedef typename V::scalar Real;
+				typedef typename V::type T;
+
+				static void apply(Real* x, int n)
+				{
+					int j = 0;
+					for (; j + V::width <= n; j += V::width) V::store(x + j, V::max(V::load(x + j), V::zero()));
+					for (; j < n; j++) x[j] = x[j] > 0 ? x[j] : 0;
+				}
+
+				//a plain loop, the compiler vectorises the select with this file's instruction set
+				static void derivative(const Real* y, Real* g, int n)
+				{
+					for (int j = 0; j < n; j++) g[j] = y[j] > 0 ? g[j] : 0;
+				}
+			};
+
+			template<typename V>
+			struct LeakyReluActivation
+			{
+				typedef typename V::scalar Real;
+				typedef typename V::type T;
+
+				//max(x, slope * x) for a slope below 1
+				static void apply(Real* x, int n)
+				{
+					int j = 0;
+					T slope = V::set1(Real(LEAKY_RELU_SLOPE));
+					for (; j + V::width <= n; j += V::width)
+					{
+						T xv = V::load(x + j);
+						V::store(x + j, V::max(xv, V::mul(slope, xv)));
+					}
+					for (; j < n; j++) x[j] = x[j] > 0 ? x[j] : Real(LEAKY_RELU_SLOPE) * x[j];
+				}
+
+				static void derivative(const Real* y, Real* g, int n)
+				{
+					for (int j = 0; j < n; j++) g[j] = y[j] > 0 ? g[j] : Real(LEAKY_RELU_SLOPE) * g[j];
+				}
+			};
+
+			template<typename V>
+			struct SoftmaxActivation
+			{
+				typedef typename V::scalar Real;
+				typedef typename V::type T;
+				typedef ScalarLane<Real> S;
+
+				//e^(x - max) / sum, shifting by the largest value keeps e^x finite
+				static void apply(Real* x, int n)
+				{
+					Real largest = x[0];
+					for (int j = 1; j < n; j++) largest = x[j] > largest ? x[j] : largest;
+
+					int j = 0;
+					T shift = V::set1(largest), sum = V::zero();
+					for (; j + V::width <= n; j += V::width)
+					{
+						T e = expApprox<V>(V::sub(V::load(x + j), shift));
+						V::store(x + j, e);
+						sum = V::add(sum, e);
+					}
+
+					Real total = V::hsum(sum);
+					for (; j < n; j++)
+					{
+						x[j] = expApprox<S>(x[j] - largest);
+						total += x[j];
+					}
+
+					T scale = V::set1(1 / total);
+					for (j = 0; j + V::width <= n; j += V::width) V::store(x + j, V::mul(V::load(x + j), scale));
+					for (; j < n; j++) x[j] *= 1 / total;
+				}
+
+				//g_i = y_i * (g_i - sum_j y_j * g_j)
+				static void derivative(const Real* y, Real* g, int n)
+				{
+					int j = 0;
+					T dot = V::zero();
+					for (; j + V::width <= n; j += V::width) dot = V::fmadd(V::load(y + j), V::load(g + j), dot);
+
+					Real total = V::hsum(dot);
+					for (; j < n; j++) total += y[j] * g[j];
+
+					T tv = V::set1(total);
+					for (j = 0; j + V::width <= n; j += V::width) V::store(g + j, V::mul(V::load(y + j), V::sub(V::load(g + j), tv)));
+					for (; j < n; j++) g[j] = y[j] * (g[j] - total);
+				}
+			};
+
+			template<typename V, typename IV>
+			struct SimdKernels
+			{
+				typedef typename V::scalar Real;
+				typedef typename V::type T;
+				typedef ScalarLane<Real> S;
+
+				static void gemv(const Real* x, const Real* w, int rows, int cols, Real* y)
+				{
+					//keep two column vectors in registers while walking down the rows
+					int j = 0;
+					for (; j + 2 * V::width <= cols; j += 2 * V::width)
+					{
+						T a0 = V::zero(), a1 = V::zero();
+						for (int i = 0; i < rows; i++)
+						{
+							const Real* row = w + i * cols + j;
+							T xi = V::set1(x[i]);
+							a0 = V::fmadd(xi, V::load(row), a0);
+							a1 = V::fmadd(xi, V::load(row + V::width), a1);
+						}
+						V::store(y + j, a0);
+						V::store(y + j + V::width, a1);
+					}
+					for (; j + V::width <= cols; j += V::width)
+					{
+						T a = V::zero();
+						for (int i = 0; i < rows; i++) a = V::fmadd(V::set1(x[i]), V::load(w + i * cols + j), a);
+						V::store(y + j, a);
+					}
+					for (; j < cols; j++)
+					{
+						Real a = 0;
+						for (int i = 0; i < rows; i++) a += x[i] * w[i * cols + j];
+						y[j] = a;
+					}
+				}
+
+				static Real dot(const Real* a, const Real* b, int n)
+				{
+					int j = 0;
+					Real sum = 0;
+					if (n >= V::width)
+					{
+						T acc = V::zero();
+						for (; j + V::width <= n; j += V::width) acc = V::fmadd(V::load(a + j), V::load(b + j), acc);
+						sum = V::hsum(acc);
+					}
+					for (; j < n; j++) sum += a[j] * b[j];
+					return sum;
+				}
+
+				static void gemvTransposed(const Real* w, int cols, const Real* g, Real* y, int n)
+				{
+					for (int i = 0; i < n; i++) y[i] = dot(w + i * cols, g, cols);
+				}
+
+				static void gemm(const Real* x, int ldx, const Real* w, int rows, int cols, Real* y, int ldy, int n)
+				{
+					//blocks of 4 patterns share every weight vector load
+					int b = 0;
+					for (; b + 4 <= n; b += 4)
+					{
+						const Real* x0 = x + b * ldx;
+						const Real* x1 = x0 + ldx;
+						const Real* x2 = x1 + ldx;
+						const Real* x3 = x2 + ldx;
+						Real* y0 = y + b * ldy;
+						Real* y1 = y0 + ldy;
+						Real* y2 = y1 + ldy;
+						Real* y3 = y2 + ldy;
+
+						int j = 0;
+						for (; j + V::width <= cols; j += V::width)
+						{
+							T a0 = V::zero(), a1 = V::zero(), a2 = V::zero(), a3 = V::zero();
+							for (int i = 0; i < rows; i++)
+							{
+								T wv = V::load(w + i * cols + j);
+								a0 = V::fmadd(V::set1(x0[i]), wv, a0);
+								a1 = V::fmadd(V::set1(x1[i]), wv, a1);
+								a2 = V::fmadd(V::set1(x2[i]), wv, a2);
+								a3 = V::fmadd(V::set1(x3[i]), wv, a3);
+							}
+							V::store(y0 + j, a0);
+							V::store(y1 + j, a1);
+							V::store(y2 + j, a2);
+							V::store(y3 + j, a3);
+						}
+						for (; j < cols; j++)
+						{
+							Real a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+							for (int i = 0; i < rows; i++)
+							{
+								Real wv = w[i * cols + j];
+								a0 += x0[i] * wv;
+								a1 += x1[i] * wv;
+								a2 += x2[i] * wv;
+								a3 += x3[i] * wv;
+							}
+							y0[j] = a0;
+							y1[j] = a1;
+							y2[j] = a2;
+							y3[j] = a3;
+						}
+					}
+
+					//remaining patterns
+					for (; b < n; b++) gemv(x + b * ldx, w, rows, cols, y + b * ldy);
+				}
+
+				static void axpby(Real* d, Real a, const Real* g, Real m, int n)
+				{
+					//d = a * g + m * d
+					int j = 0;
+					T av = V::set1(a), mv = V::set1(m);
+					for (; j + V::width <= n; j += V::width) V::store(d + j, V::fmadd(av, V::load(g + j), V::mul(mv, V::load(d + j))));
+					for (; j < n; j++) d[j] = a * g[j] + m * d[j];
+				}
+
+				static void axpy(Real* d, Real a, const Real* g, int n)
+				{
+					//d += a * g
+					int j = 0;
+					T av = V::set1(a);
+					for (; j + V::width <= n; j += V::width) V::store(d + j, V::fmadd(av, V::load(g + j), V::load(d + j)));
+					for (; j < n; j++) d[j] += a * g[j];
+				}
+
+				static void outerProductUpdate(Real* d, int rows, int cols, Real a, const Real* x, const Real* g, Real m)
+				{
+					for (int i = 0; i < rows; i++) axpby(d + i * cols, a * x[i], g, m, cols);
+				}
+
+				static void outerProductAccumulate(Real* d, int rows, int cols, Real a, const Real* x, const Real* g)
+				{
+					for (int i = 0; i < rows; i++) axpy(d + i * cols, a * x[i], g, cols);
+				}
+
+				static void outerProductAccumulateBatch(Real* d, int rows, int cols, Real a, const Real* x, int ldx, const Real* g, int ldg, int n)
+				{
+					for (int i = 0; i < rows; i++)
+					{
+						for (int b = 0; b < n; b++) axpy(d + i * cols, a * x[b * ldx + i], g + b * ldg, cols);
+					}
+				}
+
+				static void add(Real* w, const Real* d, int n)
+				{
+					int j = 0;
+					for (; j + V::width <= n; j += V::width) V::store(w + j, V::add(V::load(w + j), V::load(d + j)));
+					for (; j < n; j++) w[j] += d[j];
+				}
+
+				static void addScaled(Real* d, const Real* g, Real m, int n)
+				{
+					int j = 0;
+					T mv = V::set1(m);
+					for (; j + V::width <= n; j += V::width) V::store(d + j, V::fmadd(mv, V::load(d + j), V::load(g + j)));
+					for (; j < n; j++) d[j] = g[j] + m * d[j];
+				}
+
+				static void sigmoidFast(Real* x, int n)
+				{
+					const int degree = ExpTraits<Real>::fastDegree;
+
+					int j = 0;
+					T one = V::set1(Real(1));
+					for (; j + V::width <= n; j += V::width)
+					{
+						T e = expApprox<V, degree>(V::sub(V::zero(), V::load(x + j)));
+						V::store(x + j, V::div(one, V::add(one, e)));
+					}
+					for (; j < n; j++) x[j] = 1 / (1 + expApprox<S, degree>(-x[j]));
+				}
+
+				/*******************************************************************
+				* Fused optimizer steps over one vector of lanes L at i, shared by
+				* the vector loops and their scalar tails
+				********************************************************************/
+				template<typename L>
+				static void adamStep(Real* d, Real* m, Real* v, const Real* g, int i, Real beta1, Real beta2, Real step, Real epsilon)
+				{
+					typename L::type gi = L::load(g + i);
+					typename L::type mi = L::fmadd(L::set1(beta1), L::load(m + i), L::mul(L::set1(1 - beta1), gi));
+					typename L::type vi = L::fmadd(L::set1(beta2), L::load(v + i), L::mul(L::set1(1 - beta2), L::mul(gi, gi)));
+					L::store(m + i, mi);
+					L::store(v + i, vi);
+					L::store(d + i, L::div(L::mul(L::set1(step), mi), L::add(L::sqrt(vi), L::set1(epsilon))));
+				}
+
+				template<typename L>
+				static void rmspropStep(Real* d, Real* s, const Real* g, int i, Real rho, Real rate, Real epsilon)
+				{
+					typename L::type gi = L::load(g + i);
+					typename L::type si = L::fmadd(L::set1(rho), L::load(s + i), L::mul(L::set1(1 - rho), L::mul(gi, gi)));
+					L::store(s + i, si);
+					L::store(d + i, L::div(L::mul(L::set1(rate), gi), L::add(L::sqrt(si), L::set1(epsilon))));
+				}
+
+				template<typename L>
+				static void nesterovStep(Real* d, Real* v, const Real* g, int i, Real rate, Real momentum)
+				{
+					typename L::type step = L::mul(L::set1(rate), L::load(g + i));
+					typename L::type vi = L::fmadd(L::set1(momentum), L::load(v + i), step);
+					L::store(v + i, vi);
+					L::store(d + i, L::fmadd(L::set1(momentum), vi, step));
+				}
+
+				static void adamUpdate(Real* d, Real* m, Real* v, const Real* g, int n, Real beta1, Real beta2, Real step, Real epsilon)
+				{
+					int i = 0;
+					for (; i + V::width <= n; i += V::width) adamStep<V>(d, m, v, g, i, beta1, beta2, step, epsilon);
+					for (; i < n; i++) adamStep<S>(d, m, v, g, i, beta1, beta2, step, epsilon);
+				}
+
+				static void rmspropUpdate(Real* d, Real* s, const Real* g, int n, Real rho, Real rate, Real epsilon)
+				{
+					int i = 0;
+					for (; i + V::width <= n; i += V::width) rmspropStep<V>(d, s, g, i, rho, rate, epsilon);
+					for (; i < n; i++) rmspropStep<S>(d, s, g, i, rho, rate, epsilon);
+				}
+
+				static void nesterovUpdate(Real* d, Real* v, const Real* g, int n, Real rate, Real momentum)
+				{
+					int i = 0;
+					for (; i + V::width <= n; i += V::width) nesterovStep<V>(d, v, g, i, rate, momentum);
+					for (; i < n; i++) nesterovStep<S>(d, v, g, i, rate, momentum);
+				}
+
+				static void gemvInt8(const std::int8_t* x, const std::int8_t* w, int rows, int cols, std::int32_t* y)
+				{
+					typedef typename IV::type I;
+
+					//both inputs of a row pair as one 32 bit lane
+					auto pair = [x](int i) { return IV::set1((std::int32_t)((std::uint16_t)x[i] | ((std::uint32_t)(std::uint16_t)x[i + 1] << 16))); };
+
+					//four column vectors per pass, so a pass over the rows reads whole cache lines of the packed weights
+					int j = 0;
+					for (; j + 4 * IV::width <= cols; j += 4 * IV::width)
+					{
+						I a0 = IV::zero(), a1 = IV::zero(), a2 = IV::zero(), a3 = IV::zero();
+						for (int i = 0; i < rows; i += 2)
+						{
+							const std::int8_t* row = w + i * cols + 2 * j;
+							I xi = pair(i);
+							a0 = IV::add(a0, IV::madd(IV::loadWidened(row), xi));
+							a1 = IV::add(a1, IV::madd(IV::loadWidened(row + 2 * IV::width), xi));
+							a2 = IV::add(a2, IV::madd(IV::loadWidened(row + 4 * IV::width), xi));
+							a3 = IV::add(a3, IV::madd(IV::loadWidened(row + 6 * IV::width), xi));
+						}
+						IV::store(y + j, a0);
+						IV::store(y + j + IV::width, a1);
+						IV::store(y + j + 2 * IV::width, a2);
+						IV::store(y + j + 3 * IV::width, a3);
+					}
+					for (; j + IV::width <= cols; j += IV::width)
+					{
+						I a = IV::zero();
+						for (int i = 0; i < rows; i += 2) a = IV::add(a, IV::madd(IV::loadWidened(w + i * cols + 2 * j), pair(i)));
+						IV::store(y + j, a);
+					}
+					for (; j < cols; j++)
+					{
+						std::int32_t a = 0;
+						for (int i = 0; i < rows; i += 2) a += x[i] * w[i * cols + 2 * j] + x[i + 1] * w[i * cols + 2 * j + 1];
+						y[j] = a;
+					}
+				}
+
+				static KernelTable<Real> table(Isa isa, const char* name)
+				{
+					KernelTable<Real> t;
+					t.isa = isa;
+					t.name = name;
+					t.gemv = &gemv;
+					t.gemvTransposed = &gemvTransposed;
+					t.gemm = &gemm;
+					t.outerProductUpdate = &outerProductUpdate;
+					t.outerProductAccumulate = &outerProductAccumulate;
+					t.outerProductAccumulateBatch = &outerProductAccumulateBatch;
+					t.add = &add;
+					t.addScaled = &addScaled;
+					t.adamUpdate = &adamUpdate;
+					t.rmspropUpdate = &rmspropUpdate;
+					t.nesterovUpdate = &nesterovUpdate;
+					t.sigmoid = &SigmoidActivation<V>::apply;
+					t.sigmoidFast = &sigmoidFast;
+					t.sigmoidDerivative = &SigmoidActivation<V>::derivative;
+					t.gemvInt8 = &gemvInt8;
+					setActivation<SigmoidActivation<V>>(t, Activation::Sigmoid);
+					setActivation<TanhActivation<V>>(t, Activation::Tanh);
+					setActivation<ReluActivation<V>>(t, Activation::ReLU);
+					setActivation<LeakyReluActivation<V>>(t, Activation::LeakyReLU);
+					setActivation<SoftmaxActivation<V>>(t, Activation::Softmax);
+					return t;
+				}
+
+				template<typename Policy>
+				static void setActivation(KernelTable<Real>& t, Activation a)
+				{
+					t.activate[(int)a] = &Policy::apply;
+					t.activationDerivative[(int)a] = &Policy::derivative;
+				}
+			};
+		}
+	}
+}
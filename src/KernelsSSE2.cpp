@@ -0,0 +1,97 @@
+#include "KernelsImpl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+namespace air
+{
+	namespace kernels
+	{
+		namespace
+		{
+			struct Sse2
+			{
+				typedef double scalar;
+				typedef __m128d type;
+				static const int width = 2;
+
+				static type load(const double* p) { return _mm_loadu_pd(p); }
+				static void store(double* p, type v) { _mm_storeu_pd(p, v); }
+				static type set1(double d) { return _mm_set1_pd(d); }
+				static type zero() { return _mm_setzero_pd(); }
+				static type add(type a, type b) { return _mm_add_pd(a, b); }
+				static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+				static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+				static type div(type a, type b) { return _mm_div_pd(a, b); }
+				static type min(type a, type b) { return _mm_min_pd(a, b); }
+				static type max(type a, type b) { return _mm_max_pd(a, b); }
+				static type sqrt(type a) { return _mm_sqrt_pd(a); }
+				static type fmadd(type a, type b, type c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+				static double hsum(type v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+				static type shiftExponent(type v) { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(v), 52)); }
+			};
+
+			struct Sse2F
+			{
+				typedef float scalar;
+				typedef __m128 type;
+				static const int width = 4;
+
+				static type load(const float* p) { return _mm_loadu_ps(p); }
+				static void store(float* p, type v) { _mm_storeu_ps(p, v); }
+				static type set1(float d) { return _mm_set1_ps(d); }
+				static type zero() { return _mm_setzero_ps(); }
+				static type add(type a, type b) { return _mm_add_ps(a, b); }
+				static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+				static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+				static type div(type a, type b) { return _mm_div_ps(a, b); }
+				static type min(type a, type b) { return _mm_min_ps(a, b); }
+				static type max(type a, type b) { return _mm_max_ps(a, b); }
+				static type sqrt(type a) { return _mm_sqrt_ps(a); }
+				static type fmadd(type a, type b, type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+				static float hsum(type v)
+				{
+					__m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+					return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+				}
+				static type shiftExponent(type v) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_castps_si128(v), 23)); }
+			};
+
+			struct Sse2I
+			{
+				typedef __m128i type;
+				static const int width = 4;
+
+				static type loadWidened(const std::int8_t* p)
+				{
+					//duplicate every byte into a 16 bit lane, the arithmetic shift sign extends it
+					__m128i v = _mm_loadl_epi64((const __m128i*)p);
+					return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+				}
+				static void store(std::int32_t* p, type v) { _mm_storeu_si128((__m128i*)p, v); }
+				static type set1(std::int32_t d) { return _mm_set1_epi32(d); }
+				static type zero() { return _mm_setzero_si128(); }
+				static type add(type a, type b) { return _mm_add_epi32(a, b); }
+				static type madd(type a, type b) { return _mm_madd_epi16(a, b); }
+			};
+		}
+
+		template<>
+		const KernelTable<double>* sse2Kernels<double>()
+		{
+			static const KernelTable<double> t = SimdKernels<Sse2, Sse2I>::table(Isa::SSE2, "SSE2");
+			return &t;
+		}
+
+		template<>
+		const KernelTable<float>* sse2Kernels<float>()
+		{
+			static const KernelTable<float> t = SimdKernels<Sse2F, Sse2I>::table(Isa::SSE2, "SSE2");
+			return &t;
+		}
+	}
+}
+#else
+template<> const air::kernels::KernelTable<double>* air::kernels::sse2Kernels<double>() { return nullptr; }
+template<> const air::kernels::KernelTable<float>* air::kernels::sse2Kernels<float>() { return nullptr; }
+#endif
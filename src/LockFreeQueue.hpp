@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include "Matrix.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Bounded multi-producer multi-consumer queue without locks. Every
+	* cell carries a sequence number telling producers and consumers
+	* whose turn it is, so push and pop only contend on one atomic
+	* position each. Capacity is rounded up to a power of two.
+	********************************************************************/
+	template<typename T>
+	class LockFreeQueue
+	{
+	public:
+		explicit LockFreeQueue(int capacity) : head(0), tail(0)
+		{
+			std::size_t size = 2;
+			while (size < (std::size_t)capacity) size *= 2;
+
+			cells.reset(new Cell[size]);
+			mask = size - 1;
+			for (std::size_t i = 0; i < size; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		LockFreeQueue(const LockFreeQueue&) = delete;
+		LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+		int capacity() const { return (int)mask + 1; }
+
+		//returns false if the queue is full
+		bool push(const T& value)
+		{
+			std::size_t position = tail.load(std::memory_order_relaxed);
+			Cell* cell;
+
+			while (true)
+			{
+				cell = &cells[position & mask];
+				std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+
+				//free cell - claim it
+				if (difference == 0)
+				{
+					if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+				}
+				//not consumed yet - full
+				else if (difference < 0) return false;
+				//another producer got there first
+				else position = tail.load(std::memory_order_relaxed);
+			}
+
+			cell->value = value;
+			cell->sequence.store(position + 1, std::memory_order_release);
+			return true;
+		}
+
+		//returns false if the queue is empty
+		bool pop(T& value)
+		{
+			std::size_t position = head.load(std::memory_order_relaxed);
+			Cell* cell;
+
+			while (true)
+			{
+				cell = &cells[position & mask];
+				std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				std::ptrdiff_t difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(position + 1);
+
+				//filled cell - claim it
+				if (difference == 0)
+				{
+					if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+				}
+				//not produced yet - empty
+				else if (difference < 0) return false;
+				//another consumer got there first
+				else position = head.load(std::memory_order_relaxed);
+			}
+
+			value = cell->value;
+			cell->sequence.store(position + mask + 1, std::memory_order_release);
+			return true;
+		}
+
+		//no value claimed by a producer is waiting (a snapshot, may change right away)
+		bool empty() const { return head.load() == tail.load(); }
+
+	private:
+		struct Cell
+		{
+			std::atomic<std::size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Cell[]> cells;
+		std::size_t mask;
+
+		//producer and consumer positions on separate cache lines
+		alignas(BUFFER_ALIGNMENT) std::atomic<std::size_t> head;
+		alignas(BUFFER_ALIGNMENT) std::atomic<std::size_t> tail;
+	};
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <new>
+
+namespace air
+{
+	//alignment of all weight, delta and neuron buffers (one cache line)
+	const std::size_t BUFFER_ALIGNMENT = 64;
+
+	/*******************************************************************
+	* Allocator handing out cache line aligned memory
+	********************************************************************/
+	template<typename T, std::size_t Alignment = BUFFER_ALIGNMENT>
+	class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+
+		template<typename U>
+		struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+		AlignedAllocator() {}
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+		T* allocate(std::size_t n)
+		{
+			return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+		}
+
+		void deallocate(T* p, std::size_t)
+		{
+			::operator delete(p, std::align_val_t(Alignment));
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+		template<typename U>
+		bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+	};
+
+	template<typename T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+	//blocks template argument deduction for a parameter, so it only takes part in conversions
+	template<typename T>
+	struct NonDeduced { typedef T type; };
+
+	/*******************************************************************
+	* Non-owning row-major matrix view into a contiguous buffer
+	********************************************************************/
+	template<typename T>
+	class MatrixView
+	{
+	public:
+		MatrixView() : data(nullptr), rows(0), cols(0) {}
+		MatrixView(T* d, int r, int c) : data(d), rows(r), cols(c) {}
+
+		//allow a mutable view to be passed where a read-only view is expected
+		template<typename U>
+		MatrixView(const MatrixView<U>& m) : data(m.data), rows(m.rows), cols(m.cols) {}
+
+		T& operator()(int r, int c) const { return data[r * cols + c]; }
+		T* row(int r) const { return data + r * cols; }
+		int size() const { return rows * cols; }
+
+	public:
+		T* data;
+		int rows;
+		int cols;
+	};
+}
@@ -0,0 +1,299 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "DataReader.hpp"
+#include "NeuralNetwork.hpp"
+#include "NeuralNetworkTrainer.hpp"
+#include "Kernels.hpp"
+
+using namespace air;
+
+/*******************************************************************
+* Micro-benchmarks of the hot paths for several topologies:
+* single pattern feed forward, backpropagation + weight update
+* (stochastic and mini-batch), a full training epoch, set evaluation,
+* loading the data file (csv and binary) and the weight files. Every
+* benchmark reports ns and allocations per item (pattern or weight)
+* and items per second; the fastest of a few runs counts.
+*
+* With --baseline the results are compared against an earlier --out
+* file, a benchmark slower by more than the tolerance or allocating
+* more than before fails the run. Mini-batch training fails it as
+* well if it allocates once per batch, whatever the baseline says.
+*
+* usage: air-bench [data file] [--out results.csv] [--baseline results.csv] [--tolerance 0.2]
+********************************************************************/
+
+static std::atomic<long long> allocations(0);
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	allocations++;
+	std::size_t a = (std::size_t)alignment;
+	if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+//network shapes benchmarked, all on the 16 input / 3 target data set
+static const std::vector<std::vector<int>> TOPOLOGIES = { { 16, 20, 3 }, { 16, 64, 3 }, { 16, 128, 64, 3 }, { 16, 256, 256, 3 } };
+
+//runs of every benchmark, the fastest one counts (training runs are long enough to need fewer)
+static const int REPETITIONS = 5;
+static const int TRAINING_REPETITIONS = 3;
+
+//patterns per mini-batch of the mini-batch training benchmark
+static const int MINI_BATCH_SIZE = 32;
+
+//temporary files written by the I/O benchmarks
+static const char* BINARY_FILE = "air-bench.tmp.aird";
+static const char* WEIGHTS_FILE = "air-bench.tmp.csv";
+static const char* CHECKPOINT_FILE = "air-bench.tmp.airw";
+
+struct Result
+{
+	std::string name;
+	std::string unit;		//item the numbers are per
+	double nanoseconds;		//per item
+	double allocations;		//per item
+	double maxAllocations;	//per item, negative = no limit
+};
+
+/*******************************************************************
+* Fastest of repetitions runs of f, which handles items items. The
+* console is silenced while f runs (loading and saving print).
+********************************************************************/
+template<typename F>
+static Result measure(const std::string& name, const std::string& unit, long long items, int repetitions, F f)
+{
+	std::streambuf* console = std::cout.rdbuf(nullptr);
+
+	double best = 1e300;
+	long long startAllocations = allocations;
+	for (int r = 0; r < repetitions; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	long long runAllocations = allocations - startAllocations;
+
+	std::cout.rdbuf(console);
+	std::cout.clear();
+
+	Result r = { name, unit, best / items * 1e9, (double)runAllocations / ((long long)repetitions * items), -1 };
+	std::cout << " " << std::left << std::setw(44) << r.name << std::right << std::fixed << std::setprecision(1) << std::setw(10) << r.nanoseconds << " ns/" << std::left << std::setw(8) << r.unit
+		<< std::right << std::setprecision(0) << std::setw(12) << 1e9 / r.nanoseconds << " " << std::left << std::setw(11) << (r.unit + "s/s") << std::right << std::defaultfloat << std::setprecision(6)
+		<< std::setw(12) << r.allocations << " allocations/" << r.unit << std::endl;
+	return r;
+}
+
+static std::string topologyName(const std::vector<int>& topology)
+{
+	std::string name;
+	for (int l = 0; l < (int)topology.size(); l++) name += (l > 0 ? "-" : "") + std::to_string(topology[l]);
+	return name;
+}
+
+//trainer running exactly one epoch per trainNetwork call
+static void oneEpochPerCall(NeuralNetworkTrainer& trainer)
+{
+	trainer.setVerbose(false);
+	trainer.setStoppingConditions(1, 101, -1);
+}
+
+static void benchmarkTopology(const std::vector<int>& topology, std::shared_ptr<TrainingDataSet> set, std::vector<Result>& results)
+{
+	std::string prefix = topologyName(topology) + " ";
+
+	srand(1);
+	auto nn = std::make_shared<NeuralNetwork>(topology);
+	long long nWeights = (long long)nn->weights.size();
+
+	//the training set alone, generalization and validation shrunk to a pattern
+	auto trainingOnly = std::make_shared<TrainingDataSet>(*set);
+	trainingOnly->generalizationSet.setRange(set->generalizationSet.begin, set->generalizationSet.begin + 1);
+	trainingOnly->validationSet.setRange(set->validationSet.begin, set->validationSet.begin + 1);
+
+	const DataSubset& training = set->trainingSet;
+	const DataSubset& generalization = set->generalizationSet;
+	long long allPatterns = training.size() + generalization.size() + set->validationSet.size();
+
+	//inference
+	std::vector<double> outputs(nn->nOutput);
+	results.push_back(measure(prefix + "feedForward", "pattern", generalization.size(), REPETITIONS, [&]
+	{
+		for (int i = 0; i < generalization.size(); i++) nn->predict(generalization.pattern(i), outputs.data());
+	}));
+
+	std::vector<NeuronBatch> scratch(1, NeuronBatch(nn->topology, EVALUATION_BATCH_SIZE));
+	results.push_back(measure(prefix + "evaluateSet", "pattern", generalization.size(), REPETITIONS, [&] { nn->evaluateSet(generalization, scratch); }));
+
+	//training
+	NeuralNetworkTrainer stochastic(nn);
+	oneEpochPerCall(stochastic);
+	results.push_back(measure(prefix + "backpropagate + updateWeights", "pattern", training.size(), TRAINING_REPETITIONS, [&] { stochastic.trainNetwork(trainingOnly); }));
+
+	NeuralNetworkTrainer miniBatch(nn);
+	oneEpochPerCall(miniBatch);
+	miniBatch.setBatchSize(MINI_BATCH_SIZE);
+	results.push_back(measure(prefix + "mini-batch " + std::to_string(MINI_BATCH_SIZE) + " training", "pattern", training.size(), TRAINING_REPETITIONS, [&] { miniBatch.trainNetwork(trainingOnly); }));
+
+	//the batches run on preallocated scratch buffers, only the per call setup may allocate
+	results.back().maxAllocations = 0.5 / MINI_BATCH_SIZE;
+
+	NeuralNetworkTrainer epoch(nn);
+	oneEpochPerCall(epoch);
+	results.push_back(measure(prefix + "training epoch", "pattern", allPatterns, TRAINING_REPETITIONS, [&] { epoch.trainNetwork(set); }));
+
+	//weight files
+	results.push_back(measure(prefix + "saveWeights", "weight", nWeights, REPETITIONS, [&] { nn->saveWeights(WEIGHTS_FILE); }));
+	results.push_back(measure(prefix + "loadWeights", "weight", nWeights, REPETITIONS, [&] { nn->loadWeights(WEIGHTS_FILE); }));
+	results.push_back(measure(prefix + "saveCheckpoint", "weight", nWeights, REPETITIONS, [&] { nn->saveCheckpoint(CHECKPOINT_FILE); }));
+	results.push_back(measure(prefix + "loadCheckpoint", "weight", nWeights, REPETITIONS, [&] { nn->loadCheckpoint(CHECKPOINT_FILE); }));
+}
+
+static bool saveResults(const std::string& filename, const std::vector<Result>& results)
+{
+	std::ofstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << std::endl << "Error - Results file '" << filename << "' could not be created" << std::endl;
+		return false;
+	}
+
+	file << "benchmark,unit,ns per item,items per second,allocations per item" << std::endl << std::setprecision(10);
+	for (const Result& r : results) file << r.name << "," << r.unit << "," << r.nanoseconds << "," << 1e9 / r.nanoseconds << "," << r.allocations << std::endl;
+	return true;
+}
+
+/*******************************************************************
+* Compares the results with a file written by saveResults, returns
+* false on a regression (benchmarks missing from either side are
+* skipped) or on a benchmark allocating more than its limit
+********************************************************************/
+static bool compareResults(const std::string& filename, const std::vector<Result>& results, double tolerance)
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+	{
+		std::cout << std::endl << "Error - Baseline file '" << filename << "' could not be opened" << std::endl;
+		return false;
+	}
+
+	std::map<std::string, Result> baseline;
+	std::string line;
+	std::getline(file, line);
+	while (std::getline(file, line))
+	{
+		std::istringstream s(line);
+		std::string ns, rate, allocs;
+		Result r;
+		if (!std::getline(s, r.name, ',') || !std::getline(s, r.unit, ',') || !std::getline(s, ns, ',') || !std::getline(s, rate, ',') || !std::getline(s, allocs)) continue;
+		r.nanoseconds = atof(ns.c_str());
+		r.allocations = atof(allocs.c_str());
+		baseline[r.name] = r;
+	}
+
+	std::cout << std::endl << "Compared with '" << filename << "' (tolerance " << tolerance * 100 << "%)" << std::endl;
+
+	bool passed = true;
+	for (const Result& r : results)
+	{
+		if (r.maxAllocations >= 0 && r.allocations > r.maxAllocations)
+		{
+			std::cout << " Regression - " << r.name << ": " << r.allocations << " allocations/" << r.unit << " (limit " << r.maxAllocations << ")" << std::endl;
+			passed = false;
+		}
+
+		auto b = baseline.find(r.name);
+		if (b == baseline.end()) continue;
+
+		double change = r.nanoseconds / b->second.nanoseconds - 1;
+		bool slower = change > tolerance;
+		bool allocates = r.allocations > b->second.allocations * 1.001 + 1e-9;
+		if (slower || allocates)
+		{
+			std::cout << " Regression - " << r.name << ": " << r.nanoseconds << " ns/" << r.unit << " (baseline " << b->second.nanoseconds << ", "
+				<< std::showpos << change * 100 << std::noshowpos << "%), " << r.allocations << " allocations/" << r.unit << " (baseline " << b->second.allocations << ")" << std::endl;
+			passed = false;
+		}
+	}
+
+	if (passed) std::cout << " No regressions" << std::endl;
+	return passed;
+}
+
+int main(int argc, char** argv)
+{
+	std::string dataFile = "data.csv", resultsFile, baselineFile;
+	double tolerance = 0.2;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--out" && i + 1 < argc) resultsFile = argv[++i];
+		else if (arg == "--baseline" && i + 1 < argc) baselineFile = argv[++i];
+		else if (arg == "--tolerance" && i + 1 < argc) tolerance = atof(argv[++i]);
+		else if (arg.compare(0, 2, "--") != 0) dataFile = arg;
+		else
+		{
+			std::cout << "usage: " << argv[0] << " [data file] [--out results.csv] [--baseline results.csv] [--tolerance 0.2]" << std::endl;
+			return 1;
+		}
+	}
+
+	DataReader reader;
+	if (!reader.loadDataFile(dataFile, 16, 3)) return 1;
+	reader.setCreationApproach(STATIC, 10);
+	std::shared_ptr<TrainingDataSet> set = reader.getTrainingDataSet();
+	long long numPatterns = set->data->size();
+
+	std::cout << std::endl << "Micro-benchmarks, " << numPatterns << " patterns, " << kernels::table<double>().name << " kernels" << std::endl
+		<< "==========================================================================" << std::endl;
+
+	std::vector<Result> results;
+
+	//data files, csv as given and converted to the binary format
+	DataReader loader;
+	if (!loader.convertDataFile(dataFile, BINARY_FILE, 16, 3)) return 1;
+	results.push_back(measure("loadDataFile (csv)", "pattern", numPatterns, REPETITIONS, [&] { loader.loadDataFile(dataFile, 16, 3); }));
+	results.push_back(measure("loadDataFile (binary)", "pattern", numPatterns, REPETITIONS, [&] { loader.loadDataFile(BINARY_FILE, 16, 3); }));
+
+	for (const auto& topology : TOPOLOGIES) benchmarkTopology(topology, set, results);
+
+	std::remove(BINARY_FILE);
+	std::remove(WEIGHTS_FILE);
+	std::remove(CHECKPOINT_FILE);
+
+	if (!resultsFile.empty())
+	{
+		if (!saveResults(resultsFile, results)) return 1;
+		std::cout << std::endl << "Results saved to '" << resultsFile << "'" << std::endl;
+	}
+
+	if (!baselineFile.empty() && !compareResults(baselineFile, results, tolerance)) return 1;
+
+	return 0;
+}
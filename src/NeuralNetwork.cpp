@@ -4,45 +4,108 @@
 #include <fstream>
 #include <math.h>
 #include <algorithm>
+#include <cstring>
+#include "Kernels.hpp"
+#include "WeightFile.hpp"
 
 using namespace air;
 
-NeuralNetwork::NeuralNetwork(int nI, int nH, int layers, int nO) : nInput(nI), nHidden(nH), m_layers(layers), nOutput(nO)
+//input, "layers" hidden layers of nH neurons, output
+static std::vector<int> stackedTopology(int nI, int nH, int layers, int nO)
 {
-	//TODO: create layers of hidden neurons
-	inputNeurons = std::vector<double>(nInput + 1, 0.0);
-	/*inputNeurons.resize(nInput + 1);
-	std::fill(inputNeurons.begin(), inputNeurons.end(), 0.0);*/
+	std::vector<int> topology(layers + 2, nH);
+	topology.front() = nI;
+	topology.back() = nO;
+	return topology;
+}
 
-	//create input bias neuron
-	inputNeurons[nInput] = -1;
+template<typename Real>
+BasicNeuronBatch<Real>::BasicNeuronBatch(const std::vector<int>& t, int c) : topology(t), capacity(c)
+{
+	int size = 0;
+	for (int l = 0; l < (int)topology.size(); l++)
+	{
+		offsets.push_back(size);
+		size += capacity * (topology[l] + 1);
+	}
 
-	hiddenNeurons = std::vector<std::vector<double>>(m_layers, std::vector<double>(nHidden + 1, 0.0));
-	//create hidden bias neurons
-	for (int i = 0; i < m_layers; i++)
-		hiddenNeurons[i][nHidden] = -1;
+	data = AlignedVector<Real>(size, 0);
 
-	outputNeurons = std::vector<double>(nOutput + 1, 0.0);
+	//create input and hidden bias neurons for every pattern
+	for (int l = 0; l + 1 < (int)topology.size(); l++)
+	{
+		MatrixView<Real> m = layer(l);
+		for (int b = 0; b < capacity; b++) m(b, topology[l]) = -1;
+	}
+}
 
-	wInputHidden = std::vector<std::vector<std::vector<double>>>(m_layers, std::vector<std::vector<double>>(nInput + 1, std::vector<double>(nHidden, 0.0)));
-	wHiddenOutput = std::vector<std::vector<std::vector<double>>>(m_layers, std::vector<std::vector<double>>(nHidden + 1, std::vector<double>(nOutput, 0.0)));
+template<typename Real>
+BasicNeuralNetwork<Real>::BasicNeuralNetwork(const std::vector<int>& t) : nInput(t.front()), nOutput(t.back()), topology(t), activations(t.size() - 1, Activation::Sigmoid), activationMode(ActivationMode::Exact)
+{
+	createBuffers();
+	initializeWeights([] { return rand(); });
+}
+
+template<typename Real>
+BasicNeuralNetwork<Real>::BasicNeuralNetwork(int nI, int nH, int layers, int nO) : BasicNeuralNetwork(stackedTopology(nI, nH, layers, nO))
+{
 
-	initializeWeights();
 }
 
-NeuralNetwork::~NeuralNetwork()
+template<typename Real>
+BasicNeuralNetwork<Real>::BasicNeuralNetwork(const std::vector<int>& t, std::mt19937& rng) : nInput(t.front()), nOutput(t.back()), topology(t), activations(t.size() - 1, Activation::Sigmoid), activationMode(ActivationMode::Exact)
+{
+	createBuffers();
+	initializeWeights([&] { return rng(); });
+}
+
+template<typename Real>
+BasicNeuralNetwork<Real>::BasicNeuralNetwork(int nI, int nH, int layers, int nO, std::mt19937& rng) : BasicNeuralNetwork(stackedTopology(nI, nH, layers, nO), rng)
 {
 
 }
 
-bool NeuralNetwork::loadWeights(const std::string& filename)
+template<typename Real>
+BasicNeuralNetwork<Real>::~BasicNeuralNetwork()
+{
+
+}
+
+/*******************************************************************
+* Lay out neuron and weight buffers (weights are 0)
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetwork<Real>::createBuffers()
+{
+	int nNeurons = 0, nWeights = 0;
+	for (int l = 0; l < (int)topology.size(); l++)
+	{
+		neuronOffsets.push_back(nNeurons);
+		nNeurons += topology[l] + 1;
+
+		if (l < numWeightLayers())
+		{
+			weightOffsets.push_back(nWeights);
+			nWeights += (topology[l] + 1) * topology[l + 1];
+		}
+	}
+
+	neurons = AlignedVector<Real>(nNeurons, 0);
+	weights = AlignedVector<Real>(nWeights, 0);
+
+	//create input and hidden bias neurons
+	for (int l = 0; l < numWeightLayers(); l++) layerNeurons(l)[topology[l]] = -1;
+}
+
+template<typename Real>
+bool BasicNeuralNetwork<Real>::loadWeights(const std::string& filename)
 {
 	std::fstream inputFile;
 	inputFile.open(filename, std::ios::in);
 
 	if (inputFile.is_open())
 	{
-		std::vector<double> weights;
+		std::vector<double> loadedWeights;
 		std::string line = "";
 
 		while (!inputFile.eof())
@@ -61,7 +124,7 @@ bool NeuralNetwork::loadWeights(const std::string& filename)
 
 				while (t != NULL)
 				{
-					weights.push_back(atof(t));
+					loadedWeights.push_back(atof(t));
 
 					//move token onwards
 					t = strtok(NULL, ",");
@@ -74,7 +137,7 @@ bool NeuralNetwork::loadWeights(const std::string& filename)
 		}
 
 		//check if sufficient weights were loaded
-		if (weights.size() != ((nInput + 1) * nHidden + (nHidden + 1) * nOutput))
+		if (loadedWeights.size() != weights.size())
 		{
 			std::cout << std::endl << "Error - Incorrect number of weights in input file: " << filename << std::endl;
 
@@ -85,27 +148,8 @@ bool NeuralNetwork::loadWeights(const std::string& filename)
 		}
 		else
 		{
-			//set weights
-			int pos = 0;
-
-			for (int k = 0; k < m_layers; k++)
-			{
-				for (int i = 0; i <= nInput; i++)
-				{
-					for (int j = 0; j < nHidden; j++)
-					{
-						wInputHidden[k][i][j] = weights[pos++];
-					}
-				}
-
-				for (int i = 0; i <= nHidden; i++)
-				{
-					for (int j = 0; j < nOutput; j++)
-					{
-						wHiddenOutput[k][i][j] = weights[pos++];
-					}
-				}
-			}
+			//set weights - the file uses the same order as the weight buffer
+			std::transform(loadedWeights.begin(), loadedWeights.end(), weights.begin(), [](double w) { return (Real)w; });
 
 			//print success
 			std::cout << std::endl << "Neuron weights loaded successfuly from '" << filename << "'" << std::endl;
@@ -123,7 +167,8 @@ bool NeuralNetwork::loadWeights(const std::string& filename)
 	}
 }
 
-bool NeuralNetwork::saveWeights(const std::string& filename)
+template<typename Real>
+bool BasicNeuralNetwork<Real>::saveWeights(const std::string& filename)
 {
 	//open file for reading
 	std::fstream outputFile;
@@ -134,24 +179,10 @@ bool NeuralNetwork::saveWeights(const std::string& filename)
 		outputFile.precision(50);
 
 		//output weights
-		for (int k = 0; k < m_layers; k++)
+		for (int i = 0; i < (int)weights.size(); i++)
 		{
-			for (int i = 0; i <= nInput; i++)
-			{
-				for (int j = 0; j < nHidden; j++)
-				{
-					outputFile << wInputHidden[k][i][j] << ",";
-				}
-			}
-
-			for (int i = 0; i <= nHidden; i++)
-			{
-				for (int j = 0; j < nOutput; j++)
-				{
-					outputFile << wHiddenOutput[k][i][j];
-					if (i * nOutput + j + 1 != (nHidden + 1) * nOutput) outputFile << ",";
-				}
-			}
+			outputFile << weights[i];
+			if (i + 1 != (int)weights.size()) outputFile << ",";
 		}
 
 		//print success
@@ -169,145 +200,299 @@ bool NeuralNetwork::saveWeights(const std::string& filename)
 	}
 }
 
-std::vector<int> NeuralNetwork::feedForwardPattern(std::vector<double> pattern)
+/*******************************************************************
+* Loads a binary checkpoint (see WeightFile.hpp), the topology has to
+* match, weights of the other element type are converted
+********************************************************************/
+template<typename Real>
+bool BasicNeuralNetwork<Real>::loadCheckpoint(const std::string& filename)
 {
-	feedForward(pattern);
+	WeightFile file;
+	if (!readWeightFile(filename, file)) return false;
+
+	if (file.topology != topology || file.header.numWeights != weights.size())
+	{
+		std::cout << std::endl << "Error - Topology of checkpoint '" << filename << "' does not match the network" << std::endl;
+		return false;
+	}
+
+	convertValues(file.weights(), file.dataType(), weights.size(), weights.data());
 
-	//create copy of output results
+	std::cout << std::endl << "Neuron weights loaded successfuly from '" << filename << "'" << std::endl;
+	return true;
+}
+
+/*******************************************************************
+* Saves topology and weights as a binary checkpoint
+********************************************************************/
+template<typename Real>
+bool BasicNeuralNetwork<Real>::saveCheckpoint(const std::string& filename) const
+{
+	DataType type = sizeof(Real) == sizeof(float) ? DataType::Float32 : DataType::Float64;
+	if (!writeWeightFile(filename, topology, type, weights.data(), weights.size())) return false;
+
+	std::cout << std::endl << "Neuron weights saved to '" << filename << "'" << std::endl;
+	return true;
+}
+
+/*******************************************************************
+* Clamped outputs of a single pattern, allocates the result - use
+* classify in latency sensitive code
+********************************************************************/
+template<typename Real>
+std::vector<int> BasicNeuralNetwork<Real>::feedForwardPattern(const std::vector<double>& pattern)
+{
 	std::vector<int> results(nOutput);
-	for (int i = 0; i < nOutput; i++) results[i] = clampOutput(outputNeurons[i]);
+	classify(pattern.data(), results.data());
 
 	return results;
 }
 
-double NeuralNetwork::getSetAccuracy(std::vector<std::shared_ptr<DataEntry>>& set)
+/*******************************************************************
+* Single pattern inference: reads nInput values from pattern and
+* writes nOutput raw outputs (predict) or clamped 0 / 1 / -1 results
+* (classify) to a caller owned buffer. Both run on the network's own
+* neuron buffer, so they never allocate but must not be called from
+* several threads at once.
+*
+* Latency target: below 1 microsecond per call for the 16-20-3 game
+* network on a desktop CPU; air-bench-inference measures the latency
+* and fails if a call allocates.
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetwork<Real>::predict(const double* pattern, Real* outputs)
 {
-	double incorrectResults = 0;
+	feedForward(pattern);
+
+	const Real* output = outputNeurons();
+	std::copy(output, output + nOutput, outputs);
+}
+
+template<typename Real>
+void BasicNeuralNetwork<Real>::classify(const double* pattern, int* results)
+{
+	feedForward(pattern);
+
+	const Real* output = outputNeurons();
+	for (int k = 0; k < nOutput; k++) results[k] = clampOutput(output[k]);
+}
 
-	//for every training input array
-	for (int tp = 0; tp < (int)set.size(); tp++)
+/*******************************************************************
+* Single pattern inference on the first row of a scratch batch, any
+* number of threads can query a const network this way
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetwork<Real>::predict(const double* pattern, Real* outputs, NeuronBatch& scratch) const
+{
+	std::transform(pattern, pattern + nInput, scratch.layer(0).row(0), [](double v) { return (Real)v; });
+	feedForwardBatch(scratch, 1);
+
+	const Real* output = scratch.layer(numWeightLayers()).row(0);
+	std::copy(output, output + nOutput, outputs);
+}
+
+template<typename Real>
+void BasicNeuralNetwork<Real>::classify(const double* pattern, int* results, NeuronBatch& scratch) const
+{
+	std::transform(pattern, pattern + nInput, scratch.layer(0).row(0), [](double v) { return (Real)v; });
+	feedForwardBatch(scratch, 1);
+
+	const Real* output = scratch.layer(numWeightLayers()).row(0);
+	for (int k = 0; k < nOutput; k++) results[k] = clampOutput(output[k]);
+}
+
+template<typename Real>
+double BasicNeuralNetwork<Real>::getSetAccuracy(const DataSubset& set) const
+{
+	std::vector<NeuronBatch> scratch(1, NeuronBatch(topology, EVALUATION_BATCH_SIZE));
+	return evaluateSet(set, scratch).accuracy;
+}
+
+template<typename Real>
+double BasicNeuralNetwork<Real>::getSetMSE(const DataSubset& set) const
+{
+	std::vector<NeuronBatch> scratch(1, NeuronBatch(topology, EVALUATION_BATCH_SIZE));
+	return evaluateSet(set, scratch).mse;
+}
+
+/*******************************************************************
+* Accuracy and MSE of a set from a single forward pass. The set is
+* split into one shard per scratch batch, shards run on the pool if
+* one is given. Only the caller's scratch is written, so any number
+* of evaluations can run at once.
+********************************************************************/
+template<typename Real>
+SetStats BasicNeuralNetwork<Real>::evaluateSet(const DataSubset& set, std::vector<NeuronBatch>& scratch, ThreadPool* pool) const
+{
+	int size = (int)set.size();
+	int nShards = std::max(1, std::min((int)scratch.size(), size));
+	std::vector<double> shardIncorrect(nShards, 0.0), shardMSE(nShards, 0.0);
+
+	auto evaluateShard = [&](int s)
 	{
-		//feed inputs through network and backpropagate errors
-		feedForward(set[tp]->pattern);
+		NeuronBatch& batch = scratch[s];
+		MatrixView<Real> input = batch.layer(0);
+		MatrixView<Real> output = batch.layer(numWeightLayers());
 
-		//correct pattern flag
-		bool correctResult = true;
+		int begin = (int)((long long)size * s / nShards);
+		int end = (int)((long long)size * (s + 1) / nShards);
+		double incorrectResults = 0, mse = 0;
 
-		//check all outputs against desired output values
-		for (int k = 0; k < nOutput; k++)
+		//for every batch of patterns in the shard
+		for (int tp = begin; tp < end; tp += batch.capacity)
 		{
-			//set flag to false if desired and output differ
-			if (clampOutput(outputNeurons[k]) != set[tp]->target[k]) correctResult = false;
+			int n = std::min(batch.capacity, end - tp);
+
+			//feed inputs through network
+			for (int b = 0; b < n; b++) std::transform(set.pattern(tp + b), set.pattern(tp + b) + nInput, input.row(b), [](double v) { return (Real)v; });
+			feedForwardBatch(batch, n);
+
+			//check all outputs against desired output values
+			for (int b = 0; b < n; b++) checkPattern(output.row(b), set.target(tp + b), incorrectResults, mse);
 		}
 
-		//inc training error for a incorrect result
-		if (!correctResult) incorrectResults++;
+		shardIncorrect[s] = incorrectResults;
+		shardMSE[s] = mse;
+	};
+
+	if (pool != nullptr) pool->run(nShards, evaluateShard);
+	else for (int s = 0; s < nShards; s++) evaluateShard(s);
+
+	//combine shards in a fixed order
+	double incorrectResults = 0, mse = 0;
+	for (int s = 0; s < nShards; s++)
+	{
+		incorrectResults += shardIncorrect[s];
+		mse += shardMSE[s];
 	}
 
-	 //calculate error and return as percentage
-	return 100 - (incorrectResults / set.size() * 100);
+	//calculate error as percentage and mean squared error
+	SetStats stats;
+	stats.accuracy = 100 - (incorrectResults / size * 100);
+	stats.mse = mse / (nOutput * size);
+	return stats;
 }
 
-double NeuralNetwork::getSetMSE(std::vector<std::shared_ptr<DataEntry>>& set)
+/*******************************************************************
+* Add the outputs of a single pattern to an accuracy and MSE count
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetwork<Real>::checkPattern(const Real* outputs, const double* target, double& incorrectPatterns, double& mse) const
 {
-	double mse = 0;
+	//correct pattern flag
+	bool correctResult = true;
 
-	//for every training input array
-	for (int tp = 0; tp < (int)set.size(); tp++)
+	//check all outputs against desired output values
+	for (int k = 0; k < nOutput; k++)
 	{
-		//feed inputs through network and backpropagate errors
-		feedForward(set[tp]->pattern);
+		//set flag to false if desired and output differ
+		if (clampOutput(outputs[k]) != target[k]) correctResult = false;
 
-		//check all outputs against desired output values
-		for (int k = 0; k < nOutput; k++)
-		{
-			//sum all the MSEs together
-			mse += pow((outputNeurons[k] - set[tp]->target[k]), 2);
-		}
+		//sum all the MSEs together
+		mse += pow((outputs[k] - target[k]), 2);
 	}
-	 //calculate error and return as percentage
-	return mse / (nOutput * set.size());
+
+	//inc error for a incorrect result
+	if (!correctResult) incorrectPatterns++;
 }
 
-void NeuralNetwork::initializeWeights()
+template<typename Real>
+template<typename Random>
+void BasicNeuralNetwork<Real>::initializeWeights(Random random)
 {
-	//set range
-	double rH = 1 / sqrt((double)nInput);
-	double rO = 1 / sqrt((double)nHidden);
-
-	//set weights between input and hidden 		
-	//--------------------------------------------------------------------------------------------------------
-	for (int k = 0; k < m_layers; k++)
+	for (int l = 0; l < numWeightLayers(); l++)
 	{
-		for (int i = 0; i <= nInput; i++)
-		{
-			for (int j = 0; j < nHidden; j++)
-			{
-				//set weights to random values
-				wInputHidden[k][i][j] = (((double)(rand() % 100) + 1) / 100 * 2 * rH) - rH;
-			}
-		}
+		MatrixView<Real> w = weightMatrix(l);
 
-		//set weights between input and hidden
+		//set range from the fan-in of the layer
+		double r = 1 / sqrt((double)topology[l]);
+
+		//set weights between layer l and l + 1 (including bias neuron) to random values
 		//--------------------------------------------------------------------------------------------------------
-		for (int i = 0; i <= nHidden; i++)
+		for (int i = 0; i < w.rows; i++)
 		{
-			for (int j = 0; j < nOutput; j++)
+			for (int j = 0; j < w.cols; j++)
 			{
-				//set weights to random values
-				wHiddenOutput[k][i][j] = (((double)(rand() % 100) + 1) / 100 * 2 * rO) - rO;
+				w(i, j) = (Real)((((double)(random() % 100) + 1) / 100 * 2 * r) - r);
 			}
 		}
 	}
+}
+
+template<typename Real>
+void BasicNeuralNetwork<Real>::setActivation(int layer, Activation a)
+{
+	if (layer < 1 || layer > numWeightLayers() || (a == Activation::Softmax && layer != numWeightLayers()))
+	{
+		std::cout << std::endl << "Error - Activation not available for layer " << layer << std::endl;
+		return;
+	}
+
+	activations[layer - 1] = a;
+}
 
+template<typename Real>
+void BasicNeuralNetwork<Real>::setHiddenActivation(Activation a)
+{
+	for (int l = 1; l < numWeightLayers(); l++) setActivation(l, a);
 }
 
-inline double NeuralNetwork::activationFunction(double x)
+template<typename Real>
+inline void BasicNeuralNetwork<Real>::activationFunction(int layer, Real* x, int n) const
 {
-	//sigmoid function
-	return 1 / (1 + exp(-x));
+	//activation function over a whole layer
+	Activation a = activation(layer);
+	if (a == Activation::Sigmoid && activationMode == ActivationMode::Fast) kernels::sigmoidFast(x, n);
+	else kernels::activate(a, x, n);
 }
 
-int NeuralNetwork::clampOutput(double x)
+template<typename Real>
+int BasicNeuralNetwork<Real>::clampOutput(Real x) const
 {
 	if (x < 0.1) return 0;
 	else if (x > 0.9) return 1;
 	else return -1;
 }
 
-void NeuralNetwork::feedForward(std::vector<double> pattern)
+template<typename Real>
+void BasicNeuralNetwork<Real>::feedForward(const double* pattern)
 {
-	for (int i = 0; i < nInput; i++) inputNeurons[i] = pattern[i];
+	Real* input = inputNeurons();
+	for (int i = 0; i < nInput; i++) input[i] = (Real)pattern[i];
 
-	//Calculate Hidden Layer values - include bias neuron
+	//Calculate every following layer from the previous one - include bias neuron
 	//--------------------------------------------------------------------------------------------------------
-	for (int l = 0; l < m_layers; l++)
+	for (int l = 0; l < numWeightLayers(); l++)
 	{
-		for (int j = 0; j < nHidden; j++)
-		{
-			//clear value
-			hiddenNeurons[l][j] = 0;
+		Real* next = layerNeurons(l + 1);
 
-			//get weighted sum of pattern and bias neuron
-			for (int i = 0; i <= nInput; i++) hiddenNeurons[l][j] += inputNeurons[i] * wInputHidden[l][i][j];
+		//get weighted sum of previous layer and bias neuron
+		kernels::gemv(layerNeurons(l), weightMatrix(l), next);
 
-			//set to result of sigmoid
-			hiddenNeurons[l][j] = activationFunction(hiddenNeurons[l][j]);
-		}
+		//set to result of the activation function (bias neuron is left untouched)
+		activationFunction(l + 1, next, topology[l + 1]);
+	}
+}
 
-		//Calculating Output Layer values - include bias neuron
-		//--------------------------------------------------------------------------------------------------------
-		for (int k = 0; k < nOutput; k++)
-		{
-			//clear value
-			outputNeurons[k] = 0;
+template<typename Real>
+void BasicNeuralNetwork<Real>::feedForwardBatch(NeuronBatch& batch, int n) const
+{
+	//the input layer rows of the batch are filled by the caller
+	//Calculate every following layer for all n patterns at once - include bias neuron
+	//--------------------------------------------------------------------------------------------------------
+	for (int l = 0; l < numWeightLayers(); l++)
+	{
+		MatrixView<Real> next = batch.layer(l + 1);
 
-			//get weighted sum of pattern and bias neuron
-			for (int j = 0; j <= nHidden; j++) outputNeurons[k] += hiddenNeurons[l][j] * wHiddenOutput[l][j][k];
+		//get weighted sums of previous layer and bias neuron
+		kernels::gemm(batch.layer(l), weightMatrix(l), next, n);
 
-			//set to result of sigmoid
-			outputNeurons[k] = activationFunction(outputNeurons[k]);
-		}
+		//set to result of the activation function (bias neurons are left untouched)
+		for (int b = 0; b < n; b++) activationFunction(l + 1, next.row(b), topology[l + 1]);
 	}
 }
 
+template class air::BasicNeuronBatch<float>;
+template class air::BasicNeuronBatch<double>;
+template class air::BasicNeuralNetwork<float>;
+template class air::BasicNeuralNetwork<double>;
@@ -1,43 +1,142 @@
 #pragma once
-#include "DataReader.hpp"
+#include "DataStore.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+#include "Kernels.hpp"
 #include <vector>
 #include <string>
 #include <memory>
+#include <random>
 
 namespace air
 {
-	class NeuralNetwork
+	/*******************************************************************
+	* Neuron values of up to 'capacity' patterns: one row-major matrix
+	* per layer with a row per pattern and the bias neuron as last column
+	********************************************************************/
+	template<typename Real>
+	class BasicNeuronBatch
 	{
 	public:
+		BasicNeuronBatch(const std::vector<int>& topology, int capacity);
+
+		MatrixView<Real> layer(int l) { return MatrixView<Real>(data.data() + offsets[l], capacity, topology[l] + 1); }
+
+	public:
+		std::vector<int> topology;
+		int capacity;
+		AlignedVector<Real> data;
+		std::vector<int> offsets;				//start of each layer matrix in data
+	};
+
+	//patterns per forward pass when evaluating a data set
+	const int EVALUATION_BATCH_SIZE = 64;
+
+	//sigmoid evaluation - Exact, or Fast with an error below kernels::SIGMOID_FAST_MAX_ERROR (other activations are always exact)
+	enum class ActivationMode { Exact, Fast };
+
+	//accuracy (percentage of correct patterns) and MSE of a data set
+	struct SetStats
+	{
+		double accuracy;
+		double mse;
+	};
+
+	/*******************************************************************
+	* Multilayer perceptron with Real (float or double) weights and
+	* neurons and an activation function per layer (sigmoid unless set
+	* otherwise). Data sets, accuracy and MSE stay in double.
+	********************************************************************/
+	template<typename Real>
+	class BasicNeuralNetwork
+	{
+	public:
+		typedef Real value_type;
+		typedef BasicNeuronBatch<Real> NeuronBatch;
+
 		//constructor & destructor
-		NeuralNetwork(int numInput, int numHidden, int layers, int numOutput);
-		~NeuralNetwork();
+		//topology lists the number of neurons per layer: input, hidden layers..., output
+		BasicNeuralNetwork(const std::vector<int>& topology);
+		BasicNeuralNetwork(int numInput, int numHidden, int layers, int numOutput);
+
+		//initial weights drawn from rng instead of rand(), so networks can be created on any thread
+		BasicNeuralNetwork(const std::vector<int>& topology, std::mt19937& rng);
+		BasicNeuralNetwork(int numInput, int numHidden, int layers, int numOutput, std::mt19937& rng);
+		~BasicNeuralNetwork();
 
 		bool loadWeights(const std::string& inputFilename);
 		bool saveWeights(const std::string& outputFilename);
-		std::vector<int> feedForwardPattern(std::vector<double> pattern);
-		double getSetAccuracy(std::vector<std::shared_ptr<DataEntry>>& set);
-		double getSetMSE(std::vector<std::shared_ptr<DataEntry>>& set);
-		int clampOutput(double x);
-		void feedForward(std::vector<double> pattern);
+		bool loadCheckpoint(const std::string& inputFilename);
+		bool saveCheckpoint(const std::string& outputFilename) const;
+		std::vector<int> feedForwardPattern(const std::vector<double>& pattern);
+
+		//single pattern inference for per-frame queries (see NeuralNetwork.cpp), never allocates
+		void predict(const double* pattern, Real* outputs);
+		void classify(const double* pattern, int* results);
+
+		//the same on a caller owned scratch batch, for read-only (shared) networks
+		void predict(const double* pattern, Real* outputs, NeuronBatch& scratch) const;
+		void classify(const double* pattern, int* results, NeuronBatch& scratch) const;
+		double getSetAccuracy(const DataSubset& set) const;
+		double getSetMSE(const DataSubset& set) const;
+		SetStats evaluateSet(const DataSubset& set, std::vector<NeuronBatch>& scratch, ThreadPool* pool = nullptr) const;
+		void checkPattern(const Real* outputs, const double* target, double& incorrectPatterns, double& mse) const;
+		int clampOutput(Real x) const;
+		void feedForward(const double* pattern);
+		void feedForwardBatch(NeuronBatch& batch, int n) const;
+
+		//activation of neuron layer 1 ... numWeightLayers(), Softmax is only allowed for the output layer
+		void setActivation(int layer, Activation a);
+		void setHiddenActivation(Activation a);
+		void setOutputActivation(Activation a) { setActivation(numWeightLayers(), a); }
+		Activation activation(int layer) const { return activations[layer - 1]; }
+
+		void setActivationMode(ActivationMode mode) { activationMode = mode; }
+		ActivationMode getActivationMode() const { return activationMode; }
+
+		//number of weight layers (connections between two neuron layers)
+		int numWeightLayers() const { return (int)topology.size() - 1; }
+
+		//view of the weights from neuron layer l (plus bias) to neuron layer l + 1
+		MatrixView<Real> weightMatrix(int l) { return weightView(weights.data(), l); }
+		MatrixView<const Real> weightMatrix(int l) const { return MatrixView<const Real>(weights.data() + weightOffsets[l], topology[l] + 1, topology[l + 1]); }
+
+		//view of weight layer l inside any buffer laid out like the weights (e.g. trainer deltas)
+		MatrixView<Real> weightView(Real* buffer, int l) const { return MatrixView<Real>(buffer + weightOffsets[l], topology[l] + 1, topology[l + 1]); }
+
+		//views into the flat neuron buffer, the bias neuron is the last entry of each layer
+		Real* layerNeurons(int l) { return neurons.data() + neuronOffsets[l]; }
+		Real* inputNeurons() { return layerNeurons(0); }
+		Real* outputNeurons() { return layerNeurons(numWeightLayers()); }
 
 	private:
-		void initializeWeights();
-		inline double activationFunction(double x);
+		void createBuffers();
+
+		//random() returns a non-negative integer
+		template<typename Random>
+		void initializeWeights(Random random);
+		inline void activationFunction(int layer, Real* x, int n) const;
 
 	public:
 		//number of neurons
-		int nInput, nHidden, nOutput;
-		int m_layers; //number of hidden neuron layers
+		int nInput, nOutput;
+		std::vector<int> topology;				//neurons per layer (without bias): input, hidden..., output
+
+		//neurons - all layers back to back in one buffer, each followed by its bias neuron
+		AlignedVector<Real> neurons;
+		std::vector<int> neuronOffsets;			//start of each layer in neurons
 
-					  //neurons
-		std::vector<double> inputNeurons;
-		std::vector<std::vector<double>> hiddenNeurons;
-		std::vector<double> outputNeurons;
+		//weights - one (topology[l] + 1) x topology[l + 1] matrix per layer, in checkpoint order
+		AlignedVector<Real> weights;
+		std::vector<int> weightOffsets;			//start of each weight matrix in weights
 
-		//weights
-		std::vector<std::vector<std::vector<double>>> wInputHidden;
-		std::vector<std::vector<std::vector<double>>> wHiddenOutput;
+	private:
+		std::vector<Activation> activations;	//one per weight layer, of the layer it feeds
+		ActivationMode activationMode;
 	};
 
+	typedef BasicNeuronBatch<double> NeuronBatch;
+	typedef BasicNeuronBatch<float> NeuronBatchF;
+	typedef BasicNeuralNetwork<double> NeuralNetwork;
+	typedef BasicNeuralNetwork<float> NeuralNetworkF;
 }
@@ -1,53 +1,328 @@
 #include "NeuralNetworkTrainer.hpp"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <math.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include "Kernels.hpp"
+#include "WeightFile.hpp"
 
 using namespace air;
 
-NeuralNetworkTrainer::NeuralNetworkTrainer( std::shared_ptr<NeuralNetwork> nn )	:	NN(nn),
-																	epoch(0),
+//patterns read from a data stream at once (rounded to whole mini-batches)
+static const int STREAM_PIECE_SIZE = 4096;
+
+static const double PI = 3.14159265358979323846;
+
+namespace
+{
+	/*******************************************************************
+		* Training state block of a checkpoint, followed by the deltas (in
+	* the element type of the weights), the master weights (double), the
+	* state of the data stream's random number generator and the state
+	* of the optimizer (the rest of the block, empty without one)
+	********************************************************************/
+	struct TrainingStateHeader
+	{
+		std::uint64_t epoch;				//epochs completed
+		std::uint64_t numDeltas;
+		std::uint64_t numMasterWeights;		//0 without master weights
+		std::uint64_t rngStateSize;			//0 if not trained on a stream
+		double trainingSetAccuracy;
+		double generalizationSetAccuracy;
+		double trainingSetMSE;
+		double generalizationSetMSE;
+	};
+	static_assert(sizeof(TrainingStateHeader) == 64, "training state header has to be 64 bytes");
+}
+
+template<typename Real>
+BasicNeuralNetworkTrainer<Real>::BasicNeuralNetworkTrainer( std::shared_ptr<Network> nn )	:	NN(nn),
 																	learningRate(LEARNING_RATE),
 																	momentum(MOMENTUM),
+																	epoch(0),
 																	maxEpochs(MAX_EPOCHS),
-																	desiredAccuracy(DESIRED_ACCURACY),																	
-																	useBatch(false),
+																	desiredAccuracy(DESIRED_ACCURACY),
+																	desiredMSE(0),
+																	stoppingPatience(0),
+																	stoppingMinDelta(0),
+																	restoreBest(true),
+																	bestMSE(0),
+																	bestEpoch(0),
+																	schedule(Schedule::Constant),
+																	scheduleEpochs(0),
+																	scheduleFactor(1),
+																	minLearningRate(0),
+																	plateauMinDelta(0),
+																	plateauLearningRate(0),
+																	plateauBestMSE(0),
+																	plateauEpochs(0),
+																	loss(Loss::MSE),
 																	trainingSetAccuracy(0),
 																	validationSetAccuracy(0),
 																	generalizationSetAccuracy(0),
 																	trainingSetMSE(0),
 																	validationSetMSE(0),
-																	generalizationSetMSE(0)																	
+																	generalizationSetMSE(0),
+																	useBatch(false),
+																	batchSize(1),
+																	numThreads(1),
+																	verbose(true),
+																	loggingEnabled(false),
+																	logResolution(1),
+																	lastEpochLogged(0),
+																	checkpointEpochs(0),
+																	checkpointSeconds(0),
+																	publishEpochs(1),
+																	resumed(false),
+																	activeStream(nullptr)
 {
-	deltaInputHidden = std::vector<std::vector<std::vector<double>>>(NN->m_layers, std::vector<std::vector<double>>(NN->nInput + 1, std::vector<double>(NN->nHidden, 0.0)));
-	deltaHiddenOutput = std::vector<std::vector<std::vector<double>>>(NN->m_layers, std::vector<std::vector<double>>(NN->nHidden + 1, std::vector<double>(NN->nOutput, 0.0)));
+	deltas = AlignedVector<Real>(NN->weights.size(), 0);
 	
-	hiddenErrorGradients = std::vector<std::vector<double>>(NN->m_layers, std::vector<double> (NN->nHidden + 1, 0.0));
-	outputErrorGradients = std::vector<std::vector<double>>(NN->m_layers, std::vector<double>(NN->nOutput + 1, 0.0));
+	errorGradients = AlignedVector<Real>(NN->neurons.size(), 0);
+
+	pool.reset(new ThreadPool(numThreads));
+	createWorkers();
+}
+
+template<typename Real>
+BasicNeuralNetworkTrainer<Real>::WorkerScratch::WorkerScratch( const Network& nn, int capacity ) :	neurons(nn.topology, capacity),
+																			errorGradients(nn.topology, capacity),
+																			gradients(nn.weights.size(), 0),
+																			incorrectPatterns(0),
+																			mse(0)
+{
+
 }
 
 
 /*******************************************************************
 * Set training parameters
 ********************************************************************/
-void NeuralNetworkTrainer::setTrainingParameters( double lR, double m, bool batch )
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setTrainingParameters( double lR, double m, bool batch )
 {
 	learningRate = lR;
 	momentum = m;
 	useBatch = batch;
 }
 /*******************************************************************
+* Replace the momentum update by an optimizer, its state is sized for
+* the network and cleared
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setOptimizer( std::shared_ptr<Optimizer> o )
+{
+	optimizer = o;
+	if ( optimizer ) optimizer->reset( (int) deltas.size() );
+}
+/*******************************************************************
+* Set mini-batch size - number of patterns fed through the network
+* at once, the summed weight change is applied once per batch
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setBatchSize( int size )
+{
+	batchSize = std::max( size, 1 );
+	createWorkers();
+}
+/*******************************************************************
+* Set number of worker threads used for mini-batch and batch learning
+* (0 = one per hardware thread). Every batch is split into one shard
+* per thread, their weight changes are summed up in thread order.
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setNumThreads( int n )
+{
+	numThreads = n > 0 ? n : ThreadPool::hardwareThreads();
+	pool.reset( new ThreadPool( numThreads ) );
+	createWorkers();
+}
+/*******************************************************************
+* Keep a double precision master copy of the weights and apply all
+* updates to it (mixed precision training of float networks)
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::useMasterWeights( bool flag )
+{
+	if ( flag ) masterWeights.assign( NN->weights.begin(), NN->weights.end() );
+	else masterWeights.clear();
+}
+/*******************************************************************
+* Reload the master weights if the network weights no longer match
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::syncMasterWeights()
+{
+	for ( int i = 0; i < (int) masterWeights.size(); i++ )
+	{
+		if ( (Real) masterWeights[i] != NN->weights[i] ) masterWeights[i] = NN->weights[i];
+	}
+}
+/*******************************************************************
+* (Re)create the per thread scratch buffers
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::createWorkers()
+{
+	workers.clear();
+	for ( int t = 0; t < numThreads; t++ ) workers.push_back( WorkerScratch( *NN, batchSize ) );
+
+	evaluationScratch = std::vector<NeuronBatch>( numThreads, NeuronBatch( NN->topology, EVALUATION_BATCH_SIZE ) );
+}
+/*******************************************************************
 * Set stopping parameters
 ********************************************************************/
-void NeuralNetworkTrainer::setStoppingConditions( int mEpochs, double dAccuracy )
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setStoppingConditions( int mEpochs, double dAccuracy, double dMSE )
 {
 	maxEpochs = mEpochs;
 	desiredAccuracy = dAccuracy;	
+	desiredMSE = dMSE;
+}
+/*******************************************************************
+* Early stopping - training ends once the generalization MSE has not
+* improved for patience epochs, optionally on the best weights seen
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setEarlyStopping( int patience, double minDelta, bool restoreBestWeights )
+{
+	stoppingPatience = std::max( patience, 0 );
+	stoppingMinDelta = minDelta;
+	restoreBest = restoreBestWeights;
+}
+/*******************************************************************
+* Learning rate schedules - step multiplies the rate by factor every
+* everyEpochs epochs, cosine anneals it to minRate over periodEpochs
+* (0 = maxEpochs), reduce-on-plateau multiplies it by factor whenever
+* the generalization MSE has not improved for patience epochs. Step
+* and cosine follow the epoch counter, so they continue a resumed
+* run; the plateau rate starts over.
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setStepSchedule( int everyEpochs, double factor, double minRate )
+{
+	schedule = Schedule::Step;
+	scheduleEpochs = std::max( everyEpochs, 1 );
+	scheduleFactor = factor;
+	minLearningRate = minRate;
+}
+
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setCosineSchedule( int periodEpochs, double minRate )
+{
+	schedule = Schedule::Cosine;
+	scheduleEpochs = std::max( periodEpochs, 0 );
+	minLearningRate = minRate;
+}
+
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setPlateauSchedule( int patience, double factor, double minRate, double minDelta )
+{
+	schedule = Schedule::ReduceOnPlateau;
+	scheduleEpochs = std::max( patience, 1 );
+	scheduleFactor = factor;
+	minLearningRate = minRate;
+	plateauMinDelta = minDelta;
+}
+/*******************************************************************
+* Learning rate of the update rule in use
+********************************************************************/
+template<typename Real>
+double BasicNeuralNetworkTrainer<Real>::getLearningRate() const
+{
+	return optimizer ? optimizer->getLearningRate() : learningRate;
+}
+
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::setLearningRate( double rate )
+{
+	if ( optimizer ) optimizer->setLearningRate( rate );
+	else learningRate = rate;
+}
+/*******************************************************************
+* Learning rate of the current epoch
+********************************************************************/
+template<typename Real>
+double BasicNeuralNetworkTrainer<Real>::scheduledLearningRate( double baseRate ) const
+{
+	switch ( schedule )
+	{
+	case Schedule::Step:
+		return std::max( minLearningRate, baseRate * pow( scheduleFactor, (double) ( epoch / scheduleEpochs ) ) );
+
+	case Schedule::Cosine:
+	{
+		double period = (double) ( scheduleEpochs > 0 ? scheduleEpochs : std::max( maxEpochs, 1L ) );
+		double t = std::min( (double) epoch, period ) / period;
+		return minLearningRate + ( baseRate - minLearningRate ) * ( 1 + cos( PI * t ) ) / 2;
+	}
+
+	case Schedule::ReduceOnPlateau:
+		return plateauLearningRate;
+
+	default:
+		return baseRate;
+	}
+}
+/*******************************************************************
+* Follow the generalization MSE after an epoch - lowers the rate of
+* the plateau schedule and remembers the best epoch for early
+* stopping. Returns true once training should stop early.
+********************************************************************/
+template<typename Real>
+bool BasicNeuralNetworkTrainer<Real>::trackProgress()
+{
+	if ( schedule == Schedule::ReduceOnPlateau )
+	{
+		if ( generalizationSetMSE < plateauBestMSE - plateauMinDelta )
+		{
+			plateauBestMSE = generalizationSetMSE;
+			plateauEpochs = 0;
+		}
+		else if ( ++plateauEpochs >= scheduleEpochs && plateauLearningRate > minLearningRate )
+		{
+			plateauLearningRate = std::max( minLearningRate, plateauLearningRate * scheduleFactor );
+			plateauEpochs = 0;
+			if ( verbose ) std::cout << "Epoch :" << epoch << " Generalization MSE on a plateau, learning rate reduced to " << plateauLearningRate << std::endl;
+		}
+	}
+
+	if ( stoppingPatience == 0 ) return false;
+
+	if ( generalizationSetMSE < bestMSE - stoppingMinDelta )
+	{
+		bestMSE = generalizationSetMSE;
+		bestEpoch = epoch;
+
+		if ( restoreBest )
+		{
+			bestWeights.assign( NN->weights.begin(), NN->weights.end() );
+			bestMasterWeights.assign( masterWeights.begin(), masterWeights.end() );
+		}
+		return false;
+	}
+
+	return epoch - bestEpoch >= stoppingPatience;
+}
+/*******************************************************************
+* Go back to the weights of the best epoch
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::restoreBestWeights()
+{
+	std::copy( bestWeights.begin(), bestWeights.end(), NN->weights.begin() );
+	masterWeights.assign( bestMasterWeights.begin(), bestMasterWeights.end() );
 }
 /*******************************************************************
 * Enable training logging
 ********************************************************************/
-void NeuralNetworkTrainer::enableLogging(const std::string& filename, int resolution = 1)
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::enableLogging(const std::string& filename, int resolution)
 {
 	//create log file 
 	if ( ! logFile.is_open() )
@@ -69,55 +344,263 @@ void NeuralNetworkTrainer::enableLogging(const std::string& filename, int resolu
 	}
 }
 /*******************************************************************
-* calculate output error gradient
+* Enable periodic checkpoints - every everyEpochs epochs and/or every
+* everySeconds seconds a copy of the weights and the training state
+* is handed to a background thread, which writes it next to the
+* target file and renames it into place, so a crash never leaves a
+* half written checkpoint behind
 ********************************************************************/
-inline double NeuralNetworkTrainer::getOutputErrorGradient( double desiredValue, double outputValue)
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::enableCheckpointing(const std::string& filename, int everyEpochs, double everySeconds)
 {
-	//return error gradient
-	return outputValue * ( 1 - outputValue ) * ( desiredValue - outputValue );
+	checkpointFilename = filename;
+	checkpointEpochs = std::max( everyEpochs, 0 );
+	checkpointSeconds = std::max( everySeconds, 0.0 );
+
+	if ( !checkpointWriter ) checkpointWriter.reset( new CheckpointWriter() );
 }
+/*******************************************************************
+* Restore weights, momentum deltas, master weights, epoch counter and
+* the data stream's shuffle state from a checkpoint, the next call to
+* trainNetwork continues where the checkpointed run left off
+********************************************************************/
+template<typename Real>
+bool BasicNeuralNetworkTrainer<Real>::resumeFromCheckpoint(const std::string& filename)
+{
+	WeightFile file;
+	if ( !readWeightFile( filename, file ) ) return false;
+
+	if ( file.topology != NN->topology || file.header.numWeights != NN->weights.size() )
+	{
+		std::cout << std::endl << "Error - Topology of checkpoint '" << filename << "' does not match the network" << std::endl;
+		return false;
+	}
+
+	TrainingStateHeader state;
+	std::size_t valueSize = dataTypeSize( file.dataType() );
+	if ( file.header.stateSize < sizeof(state) )
+	{
+		std::cout << std::endl << "Error - Checkpoint '" << filename << "' holds no training state" << std::endl;
+		return false;
+	}
+	std::memcpy( &state, file.state(), sizeof(state) );
+
+	std::size_t fixedSize = sizeof(state) + state.numDeltas * valueSize + state.numMasterWeights * sizeof(double) + state.rngStateSize;
+	if ( state.numDeltas != deltas.size() || ( state.numMasterWeights != 0 && state.numMasterWeights != deltas.size() ) || fixedSize > file.header.stateSize )
+	{
+		std::cout << std::endl << "Error - Training state of checkpoint '" << filename << "' does not match the network" << std::endl;
+		return false;
+	}
+
+	//optimizer state first, it is the only part that can still fail
+	std::size_t optimizerStateSize = file.header.stateSize - fixedSize;
+	if ( optimizer ? optimizerStateSize != 0 && !optimizer->loadState( file.state() + fixedSize, optimizerStateSize ) : optimizerStateSize != 0 )
+	{
+		std::cout << std::endl << "Error - Optimizer state of checkpoint '" << filename << "' does not match the trainer's optimizer" << std::endl;
+		return false;
+	}
+	if ( optimizer && optimizerStateSize == 0 ) optimizer->reset( (int) deltas.size() );
+
+	const char* p = file.state() + sizeof(state);
+	convertValues( file.weights(), file.dataType(), NN->weights.size(), NN->weights.data() );
+	convertValues( p, file.dataType(), deltas.size(), deltas.data() );
+	p += state.numDeltas * valueSize;
+
+	masterWeights.resize( state.numMasterWeights );
+	std::memcpy( masterWeights.data(), p, state.numMasterWeights * sizeof(double) );
+	p += state.numMasterWeights * sizeof(double);
+
+	streamRngState.assign( p, state.rngStateSize );
+
+	epoch = (long) state.epoch;
+	trainingSetAccuracy = state.trainingSetAccuracy;
+	generalizationSetAccuracy = state.generalizationSetAccuracy;
+	trainingSetMSE = state.trainingSetMSE;
+	generalizationSetMSE = state.generalizationSetMSE;
+	resumed = true;
+
+	if ( verbose ) std::cout << std::endl << "Training resumed from '" << filename << "' after epoch " << epoch << std::endl;
+	return true;
+}
+/*******************************************************************
+* Publish weight snapshots while training - the network itself is
+* only touched by the trainer, inference runs on the snapshots
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::publishSnapshots(std::shared_ptr<Publisher> p, int everyEpochs)
+{
+	publisher = p;
+	publishEpochs = std::max( everyEpochs, 1 );
+}
+/*******************************************************************
+* Is a periodic checkpoint due after the current epoch
+********************************************************************/
+template<typename Real>
+bool BasicNeuralNetworkTrainer<Real>::checkpointDue() const
+{
+	if ( !checkpointWriter ) return false;
+	if ( checkpointEpochs > 0 && epoch % checkpointEpochs == 0 ) return true;
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - lastCheckpoint;
+	return checkpointSeconds > 0 && elapsed.count() >= checkpointSeconds;
+}
+/*******************************************************************
+* Copy weights and training state and hand them to the writer thread,
+* only the copy happens on the training thread
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::writeCheckpoint()
+{
+	TrainingStateHeader state = {};
+	state.epoch = epoch;
+	state.numDeltas = deltas.size();
+	state.numMasterWeights = masterWeights.size();
+	state.trainingSetAccuracy = trainingSetAccuracy;
+	state.generalizationSetAccuracy = generalizationSetAccuracy;
+	state.trainingSetMSE = trainingSetMSE;
+	state.generalizationSetMSE = generalizationSetMSE;
+
+	std::string rngState = activeStream != nullptr ? activeStream->rngState() : std::string();
+	state.rngStateSize = rngState.size();
+
+	std::vector<char> optimizerState = optimizer ? optimizer->saveState() : std::vector<char>();
+
+	//lay out the state block
+	auto block = std::make_shared<std::vector<char>>( sizeof(state) + deltas.size() * sizeof(Real) + masterWeights.size() * sizeof(double) + rngState.size() + optimizerState.size() );
+	char* p = block->data();
+	std::memcpy( p, &state, sizeof(state) );
+	p += sizeof(state);
+	std::memcpy( p, deltas.data(), deltas.size() * sizeof(Real) );
+	p += deltas.size() * sizeof(Real);
+	std::memcpy( p, masterWeights.data(), masterWeights.size() * sizeof(double) );
+	p += masterWeights.size() * sizeof(double);
+	std::memcpy( p, rngState.data(), rngState.size() );
+	p += rngState.size();
+	std::memcpy( p, optimizerState.data(), optimizerState.size() );
+
+	auto weights = std::make_shared<std::vector<Real>>( NN->weights.begin(), NN->weights.end() );
+	std::vector<int> topology = NN->topology;
+	std::string filename = checkpointFilename;
+	DataType type = sizeof(Real) == sizeof(float) ? DataType::Float32 : DataType::Float64;
+
+	checkpointWriter->submit( [=]
+	{
+		std::string temporary = filename + ".tmp";
+		if ( !writeWeightFile( temporary, topology, type, weights->data(), weights->size(), *block ) ) return;
+
+		std::error_code error;
+		std::filesystem::rename( temporary, filename, error );
+		if ( error ) std::cout << std::endl << "Error - Checkpoint '" << filename << "' could not be written: " << error.message() << std::endl;
+	});
 
+	lastCheckpoint = std::chrono::steady_clock::now();
+}
 /*******************************************************************
-* calculate input error gradient
+* calculate output error gradients - the squared error goes through
+* the output activation's derivative, for cross-entropy of softmax
+* or sigmoid outputs the derivative cancels out
 ********************************************************************/
-double NeuralNetworkTrainer::getHiddenErrorGradient(int layer, int j )
+template<typename Real>
+inline void BasicNeuralNetworkTrainer<Real>::getOutputErrorGradients( const double* desiredValues, const Real* outputValues, Real* gradients ) const
 {
-	//get sum of hidden->output weights * output error gradients
-	double weightedSum = 0;
-	for( int k = 0; k < NN->nOutput; k++ ) weightedSum += NN->wHiddenOutput[layer][j][k] * outputErrorGradients[layer][k];
+	for ( int k = 0; k < NN->nOutput; k++ ) gradients[k] = (Real) ( desiredValues[k] - outputValues[k] );
 
-	//return error gradient
-	return NN->hiddenNeurons[layer][j] * ( 1 - NN->hiddenNeurons[layer][j] ) * weightedSum;
+	if ( loss == Loss::MSE ) kernels::activationDerivative( NN->activation( NN->numWeightLayers() ), outputValues, gradients, NN->nOutput );
 }
+
 /*******************************************************************
 * Train the NN using gradient descent
 ********************************************************************/
-void NeuralNetworkTrainer::trainNetwork( std::shared_ptr<TrainingDataSet> tSet )
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::trainNetwork( std::shared_ptr<TrainingDataSet> tSet )
 {
-	std::cout	<< std::endl << " Neural Network Training Starting: " << std::endl
+	trainEpochs( [&] { runTrainingEpoch( tSet->trainingSet ); }, &tSet->generalizationSet, &tSet->validationSet );
+}
+/*******************************************************************
+* Train the NN on a data stream, every epoch is one pass over the
+* stream. The generalization and validation sets of tSet are used if
+* given, otherwise the training accuracy decides when to stop.
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::trainNetwork( DataStream& stream, std::shared_ptr<TrainingDataSet> tSet )
+{
+	//continue the shuffle order of a resumed run
+	if ( !streamRngState.empty() ) stream.setRngState( streamRngState );
+	streamRngState.clear();
+
+	activeStream = &stream;
+	trainEpochs( [&] { runStreamEpoch( stream ); }, tSet ? &tSet->generalizationSet : nullptr, tSet ? &tSet->validationSet : nullptr );
+	activeStream = nullptr;
+}
+/*******************************************************************
+* Run training epochs until a stopping condition is met
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::trainEpochs( const std::function<void()>& runEpoch, const DataSubset* generalizationSet, const DataSubset* validationSet )
+{
+	//hidden layer sizes, e.g. "20-10"
+	std::string hiddenLayout;
+	for ( int l = 1; l < NN->numWeightLayers(); l++ ) hiddenLayout += ( l > 1 ? "-" : "" ) + std::to_string( NN->topology[l] );
+
+	//update rule
+	std::ostringstream rule;
+	if ( optimizer ) rule << optimizer->describe();
+	else rule << "LR: " << learningRate << ", Momentum: " << momentum;
+
+	if ( verbose ) std::cout	<< std::endl << " Neural Network Training Starting: " << std::endl
 			<< "==========================================================================" << std::endl
-			<< " LR: " << learningRate << ", Momentum: " << momentum << ", Max Epochs: " << maxEpochs << std::endl
-			<< " " << NN->nInput << " Input Neurons, " << NN->nHidden << " Hidden Neurons, " << NN->nOutput << " Output Neurons" << std::endl
+			<< " " << rule.str() << ", Batch Size: " << batchSize << ", Threads: " << numThreads << ", Max Epochs: " << maxEpochs << std::endl
+			<< " " << NN->nInput << " Input Neurons, " << hiddenLayout << " Hidden Neurons, " << NN->nOutput << " Output Neurons, " << kernels::table<Real>().name << " Kernels" << std::endl
 			<< "==========================================================================" << std::endl << std::endl;
 
-	//reset epoch and log counters
-	epoch = 0;
-	lastEpochLogged = -logResolution;
+	//pick up weights changed outside the trainer (e.g. loaded from file)
+	syncMasterWeights();
+
+	//reset epoch and log counters, a resumed run keeps counting
+	if ( !resumed ) epoch = 0;
+	resumed = false;
+	lastEpochLogged = epoch - logResolution;
+	lastCheckpoint = std::chrono::steady_clock::now();
+
+	//the schedule starts from the current learning rate, which is restored once training ends
+	double baseRate = getLearningRate();
+	plateauLearningRate = baseRate;
+	plateauBestMSE = bestMSE = std::numeric_limits<double>::max();
+	plateauEpochs = 0;
+	bestEpoch = epoch;
+	bestWeights.clear();
+	bestMasterWeights.clear();
+
+	bool stoppedEarly = false, desiredMSEReached = false;
 		
 	//train network using training dataset for training and generalization dataset for testing
 	//--------------------------------------------------------------------------------------------------------
-	while (	( trainingSetAccuracy < desiredAccuracy || generalizationSetAccuracy < desiredAccuracy ) && epoch < maxEpochs )				
+	while (	( trainingSetAccuracy < desiredAccuracy || generalizationSetAccuracy < desiredAccuracy ) && !desiredMSEReached && !stoppedEarly && epoch < maxEpochs )				
 	{			
 		//store previous accuracy
 		double previousTAccuracy = trainingSetAccuracy;
 		double previousGAccuracy = generalizationSetAccuracy;
 
 		//use training set to train network
-		runTrainingEpoch( tSet->trainingSet );
+		setLearningRate( scheduledLearningRate( baseRate ) );
+		runEpoch();
 
 		//get generalization set accuracy and MSE
-		generalizationSetAccuracy = NN->getSetAccuracy( tSet->generalizationSet );
-		generalizationSetMSE = NN->getSetMSE( tSet->generalizationSet );
+		if ( generalizationSet != nullptr )
+		{
+			SetStats generalizationStats = NN->evaluateSet( *generalizationSet, evaluationScratch, pool.get() );
+			generalizationSetAccuracy = generalizationStats.accuracy;
+			generalizationSetMSE = generalizationStats.mse;
+		}
+		else
+		{
+			generalizationSetAccuracy = trainingSetAccuracy;
+			generalizationSetMSE = trainingSetMSE;
+		}
+
+		//stop on the MSE goal (if set) or once the generalization MSE no longer improves
+		desiredMSEReached = desiredMSE > 0 && generalizationSetMSE <= desiredMSE;
+		stoppedEarly = trackProgress();
 
 		//Log Training results
 		if ( loggingEnabled && logFile.is_open() && ( epoch - lastEpochLogged == logResolution ) ) 
@@ -127,7 +610,7 @@ void NeuralNetworkTrainer::trainNetwork( std::shared_ptr<TrainingDataSet> tSet )
 		}
 		
 		//print out change in training /generalization accuracy (only if a change is greater than a percent)
-		if ( ceil(previousTAccuracy) != ceil(trainingSetAccuracy) || ceil(previousGAccuracy) != ceil(generalizationSetAccuracy) ) 
+		if ( verbose && ( ceil(previousTAccuracy) != ceil(trainingSetAccuracy) || ceil(previousGAccuracy) != ceil(generalizationSetAccuracy) ) ) 
 		{	
 			std::cout << "Epoch :" << epoch;
 			std::cout << " TSet Acc:" << trainingSetAccuracy << "%, MSE: " << trainingSetMSE ;
@@ -137,139 +620,328 @@ void NeuralNetworkTrainer::trainNetwork( std::shared_ptr<TrainingDataSet> tSet )
 		//once training set is complete increment epoch
 		epoch++;
 
+		if ( publisher && epoch % publishEpochs == 0 ) publisher->publish( *NN );
+		if ( checkpointDue() ) writeCheckpoint();
+	}
+
+	setLearningRate( baseRate );
+
+	bool restored = false;
+	if ( stoppedEarly )
+	{
+		if ( verbose ) std::cout << std::endl << "Early stopping - Generalization MSE has not improved since epoch " << bestEpoch << std::endl;
+
+		//continue with the best weights, their generalization stats replace the last epoch's
+		if ( restoreBest && !bestWeights.empty() )
+		{
+			restoreBestWeights();
+			restored = true;
+			if ( generalizationSet != nullptr )
+			{
+				SetStats generalizationStats = NN->evaluateSet( *generalizationSet, evaluationScratch, pool.get() );
+				generalizationSetAccuracy = generalizationStats.accuracy;
+				generalizationSetMSE = generalizationStats.mse;
+			}
+			if ( verbose ) std::cout << " Weights restored from epoch " << bestEpoch << std::endl;
+		}
+	}
+
+	//final weights
+	if ( publisher && ( epoch % publishEpochs != 0 || restored ) ) publisher->publish( *NN );
+
+	//final checkpoint, on disk once training returns
+	if ( checkpointWriter )
+	{
+		writeCheckpoint();
+		checkpointWriter->flush();
 	}
 
 	//get validation set accuracy and MSE
-	validationSetAccuracy = NN->getSetAccuracy(tSet->validationSet);
-	validationSetMSE = NN->getSetMSE(tSet->validationSet);
+	if ( validationSet != nullptr )
+	{
+		SetStats validationStats = NN->evaluateSet( *validationSet, evaluationScratch, pool.get() );
+		validationSetAccuracy = validationStats.accuracy;
+		validationSetMSE = validationStats.mse;
+	}
+	else
+	{
+		validationSetAccuracy = generalizationSetAccuracy;
+		validationSetMSE = generalizationSetMSE;
+	}
 
 	//log end
 	logFile << epoch << "," << trainingSetAccuracy << "," << generalizationSetAccuracy << "," << trainingSetMSE << "," << generalizationSetMSE << std::endl << std::endl;
 	logFile << "Training Complete!!! - > Elapsed Epochs: " << epoch << " Validation Set Accuracy: " << validationSetAccuracy << " Validation Set MSE: " << validationSetMSE << std::endl;
 			
 	//out validation accuracy and MSE
-	std::cout << std::endl << "Training Complete!!! - > Elapsed Epochs: " << epoch << std::endl;
-	std::cout << " Validation Set Accuracy: " << validationSetAccuracy << std::endl;
-	std::cout << " Validation Set MSE: " << validationSetMSE << std::endl << std::endl;
+	if ( verbose )
+	{
+		std::cout << std::endl << "Training Complete!!! - > Elapsed Epochs: " << epoch << std::endl;
+		std::cout << " Validation Set Accuracy: " << validationSetAccuracy << std::endl;
+		std::cout << " Validation Set MSE: " << validationSetMSE << std::endl << std::endl;
+	}
 }
 /*******************************************************************
 * Run a single training epoch
 ********************************************************************/
-void NeuralNetworkTrainer::runTrainingEpoch( std::vector<std::shared_ptr<DataEntry>> trainingSet )
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::runTrainingEpoch( const DataSubset& trainingSet )
 {
 	//incorrect patterns
 	double incorrectPatterns = 0;
 	double mse = 0;
-		
-	//for every training pattern
-	for ( int tp = 0; tp < (int) trainingSet.size(); tp++)
-	{						
-		//feed inputs through network and backpropagate errors
-		NN->feedForward( trainingSet[tp]->pattern );
-		backpropagate( trainingSet[tp]->target );	
-
-		//pattern correct flag
-		bool patternCorrect = true;
-
-		//check all outputs from neural network against desired values
-		for ( int k = 0; k < NN->nOutput; k++ )
-		{					
-			//pattern incorrect if desired and output differ
-			if ( NN->clampOutput( NN->outputNeurons[k] ) != trainingSet[tp]->target[k] ) patternCorrect = false;
-			
-			//calculate MSE
-			mse += pow(( NN->outputNeurons[k] - trainingSet[tp]->target[k] ), 2);
-		}
-		
-		//if pattern is incorrect add to incorrect count
-		if ( !patternCorrect ) incorrectPatterns++;	
-		
-	}//end for
+
+	trainPatterns( trainingSet, incorrectPatterns, mse );
 
 	//if using batch learning - update the weights
-	if ( useBatch ) updateWeights();
+	if ( useBatch )
+	{
+		computeDeltas( deltas.data() );
+		updateWeights();
+	}
 	
 	//update training accuracy and MSE
 	trainingSetAccuracy = 100 - (incorrectPatterns/trainingSet.size() * 100);
 	trainingSetMSE = mse / ( NN->nOutput * trainingSet.size() );
 }
 /*******************************************************************
-* Propagate errors back through NN and calculate delta values
+* Run a single training epoch over one pass of a data stream, the
+* stream is read in pieces of whole mini-batches
 ********************************************************************/
-void NeuralNetworkTrainer::backpropagate( std::vector<double> desiredOutputs )
-{		
-	//modify deltas between hidden and output layers
-	//--------------------------------------------------------------------------------------------------------
-	for (int layer = 0; layer < NN->m_layers; layer++)
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::runStreamEpoch( DataStream& stream )
+{
+	double incorrectPatterns = 0;
+	double mse = 0;
+	long long count = 0;
+
+	int piece = batchSize * std::max( 1, STREAM_PIECE_SIZE / batchSize );
+
+	stream.rewind();
+	for ( int n = stream.nextBatch( streamPiece, piece ); n > 0; n = stream.nextBatch( streamPiece, piece ) )
 	{
-		for (int k = 0; k < NN->nOutput; k++)
+		trainPatterns( DataSubset( &streamPiece, 0, n ), incorrectPatterns, mse );
+		count += n;
+	}
+
+	//if using batch learning - update the weights
+	if ( useBatch )
+	{
+		computeDeltas( deltas.data() );
+		updateWeights();
+	}
+
+	//update training accuracy and MSE
+	trainingSetAccuracy = count > 0 ? 100 - ( incorrectPatterns / count * 100 ) : 0;
+	trainingSetMSE = count > 0 ? mse / ( NN->nOutput * count ) : 0;
+}
+/*******************************************************************
+* Train on every pattern of a set once, adds up incorrect patterns
+* and squared errors. In batch learning mode the summed change is
+* left in deltas for the caller to apply.
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::trainPatterns( const DataSubset& trainingSet, double& incorrectPatterns, double& mse )
+{
+	int size = (int) trainingSet.size();
+		
+	if ( batchSize == 1 && !useBatch )
+	{
+		//for every training pattern
+		for ( int tp = 0; tp < size; tp++ )
+		{						
+			//feed inputs through network and backpropagate errors
+			NN->feedForward( trainingSet.pattern(tp) );
+			backpropagate( trainingSet.target(tp) );	
+
+			NN->checkPattern( NN->outputNeurons(), trainingSet.target(tp), incorrectPatterns, mse );
+		}
+	}
+	else
+	{
+		//patterns per weight update - the whole set when using batch learning
+		int stepSize = useBatch ? size : batchSize;
+
+		//current mini-batch, split into one contiguous shard per worker
+		int tp = 0, n = 0, nWorkers = 0;
+
+		//the task is built once per pass, its captures are too big for std::function to store without allocating
+		const std::function<void( int )> shardTask = [&]( int t )
 		{
-			//get error gradient for every output node
-			outputErrorGradients[layer][k] = getOutputErrorGradient(desiredOutputs[k], NN->outputNeurons[k]);
+			int begin = tp + (int) ( (long long) n * t / nWorkers );
+			int end = tp + (int) ( (long long) n * ( t + 1 ) / nWorkers );
+			runShard( workers[t], trainingSet, begin, end - begin );
+		};
 
-			//for all nodes in hidden layer and bias neuron
-			for (int j = 0; j <= NN->nHidden; j++)
+		//for every mini-batch of patterns
+		for ( tp = 0; tp < size; tp += stepSize )
+		{
+			n = std::min( stepSize, size - tp );
+			nWorkers = std::min( (int) workers.size(), n );
+			pool->run( nWorkers, shardTask );
+
+			//sum up the workers' weight changes in a fixed order
+			AlignedVector<Real>& gradients = workers[0].gradients;
+			for ( int t = 1; t < nWorkers; t++ )
+			{
+				kernels::add( gradients.data(), workers[t].gradients.data(), (int) gradients.size() );
+				std::fill( workers[t].gradients.begin(), workers[t].gradients.end(), 0.0 );
+			}
+
+			//mini-batch learning applies the summed change (with momentum or the optimizer) once per batch
+			if ( !useBatch )
 			{
-				//calculate change in weight
-				if (!useBatch) deltaHiddenOutput[layer][j][k] = learningRate * NN->hiddenNeurons[layer][j] * outputErrorGradients[layer][k] + momentum * deltaHiddenOutput[layer][j][k];
-				else deltaHiddenOutput[layer][j][k] += learningRate * NN->hiddenNeurons[layer][j] * outputErrorGradients[layer][k];
+				if ( optimizer ) computeDeltas( gradients.data() );
+				else kernels::addScaled( deltas.data(), gradients.data(), momentum, (int) deltas.size() );
+				updateWeights();
 			}
+			else kernels::add( deltas.data(), gradients.data(), (int) deltas.size() );
+
+			std::fill( gradients.begin(), gradients.end(), 0.0 );
 		}
 
-		//modify deltas between input and hidden layers
-		//--------------------------------------------------------------------------------------------------------
-		for (int j = 0; j < NN->nHidden; j++)
+		//collect the workers' stats
+		for ( auto& w : workers )
 		{
-			//get error gradient for every hidden node
-			hiddenErrorGradients[layer][j] = getHiddenErrorGradient(layer, j);
+			incorrectPatterns += w.incorrectPatterns;
+			mse += w.mse;
+			w.incorrectPatterns = w.mse = 0;
+		}
+	}
+}
+/*******************************************************************
+* Feed n patterns from start through the network and backpropagate
+* their errors, in pieces that fit the worker's scratch buffers
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::runShard( WorkerScratch& scratch, const DataSubset& trainingSet, int start, int n )
+{
+	for ( int tp = start; tp < start + n; tp += scratch.neurons.capacity )
+	{
+		int count = std::min( scratch.neurons.capacity, start + n - tp );
 
-			//for all nodes in input layer and bias neuron
-			for (int i = 0; i <= NN->nInput; i++)
-			{
-				//calculate change in weight 
-				if (!useBatch) deltaInputHidden[layer][i][j] = learningRate * NN->inputNeurons[i] * hiddenErrorGradients[layer][j] + momentum * deltaInputHidden[layer][i][j];
-				else deltaInputHidden[layer][i][j] += learningRate * NN->inputNeurons[i] * hiddenErrorGradients[layer][j];
+		//gather the patterns into the input layer of the batch
+		MatrixView<Real> input = scratch.neurons.layer(0);
+		for ( int b = 0; b < count; b++ ) std::transform( trainingSet.pattern(tp + b), trainingSet.pattern(tp + b) + NN->nInput, input.row(b), []( double v ) { return (Real) v; } );
 
-			}
+		//feed all inputs through network at once and backpropagate errors
+		NN->feedForwardBatch( scratch.neurons, count );
+		backpropagateBatch( scratch, trainingSet, tp, count );
+
+		MatrixView<Real> output = scratch.neurons.layer( NN->numWeightLayers() );
+		for ( int b = 0; b < count; b++ ) NN->checkPattern( output.row(b), trainingSet.target(tp + b), scratch.incorrectPatterns, scratch.mse );
+	}
+}
+/*******************************************************************
+* Propagate errors back through NN and calculate delta values
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::backpropagate( const double* desiredOutputs )
+{		
+	int last = NN->numWeightLayers();
+
+	//get error gradient for every output node
+	//--------------------------------------------------------------------------------------------------------
+	Real* outputNeurons = NN->outputNeurons();
+	Real* outputGradients = errorGradients.data() + NN->neuronOffsets[last];
+	getOutputErrorGradients( desiredOutputs, outputNeurons, outputGradients );
+
+	//walk back through the layers
+	//--------------------------------------------------------------------------------------------------------
+	for ( int l = last - 1; l >= 0; l-- )
+	{
+		Real* neurons = NN->layerNeurons(l);
+		Real* nextGradients = errorGradients.data() + NN->neuronOffsets[l + 1];
+
+		//calculate change in weight for all nodes in layer l and bias neuron (just the gradient for an optimizer)
+		MatrixView<Real> delta = NN->weightView( deltas.data(), l );
+		if ( optimizer ) kernels::outerProductUpdate( delta, 1, neurons, nextGradients, 0 );
+		else if ( !useBatch ) kernels::outerProductUpdate( delta, learningRate, neurons, nextGradients, momentum );
+		else kernels::outerProductAccumulate( delta, learningRate, neurons, nextGradients );
+
+		//get error gradient for every hidden node from the sum of outgoing weights * next layer gradients
+		if ( l > 0 )
+		{
+			Real* gradients = errorGradients.data() + NN->neuronOffsets[l];
+			kernels::gemvTransposed( NN->weightMatrix(l), nextGradients, gradients, NN->topology[l] );
+			kernels::activationDerivative( NN->activation(l), neurons, gradients, NN->topology[l] );
 		}
 	}
 	
 	//if using stochastic learning update the weights immediately
-	if ( !useBatch ) updateWeights();
+	if ( !useBatch )
+	{
+		computeDeltas( deltas.data() );
+		updateWeights();
+	}
 }
 /*******************************************************************
-* Update weights using delta values
+* Propagate errors of n patterns in the worker's batch back through
+* NN at once and sum their weight changes into the worker's gradients
 ********************************************************************/
-void NeuralNetworkTrainer::updateWeights()
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::backpropagateBatch( WorkerScratch& scratch, const DataSubset& trainingSet, int start, int n )
 {
-	for (int layer = 0; layer < NN->m_layers; layer++)
+	int last = NN->numWeightLayers();
+	const Network& nn = *NN;
+
+	//get error gradient for every output node of every pattern
+	//--------------------------------------------------------------------------------------------------------
+	MatrixView<Real> outputs = scratch.neurons.layer(last);
+	MatrixView<Real> outputGradients = scratch.errorGradients.layer(last);
+	for ( int b = 0; b < n; b++ ) getOutputErrorGradients( trainingSet.target(start + b), outputs.row(b), outputGradients.row(b) );
+
+	//walk back through the layers
+	//--------------------------------------------------------------------------------------------------------
+	for ( int l = last - 1; l >= 0; l-- )
 	{
-		//input -> hidden weights
-		//--------------------------------------------------------------------------------------------------------
-		for (int i = 0; i <= NN->nInput; i++)
-		{
-			for (int j = 0; j < NN->nHidden; j++)
-			{
-				//update weight
-				NN->wInputHidden[layer][i][j] += deltaInputHidden[layer][i][j];
+		MatrixView<Real> neurons = scratch.neurons.layer(l);
+		MatrixView<Real> nextGradients = scratch.errorGradients.layer(l + 1);
 
-				//clear delta only if using batch (previous delta is needed for momentum
-				if (useBatch) deltaInputHidden[layer][i][j] = 0;
-			}
-		}
+		//sum change in weight over all patterns for all nodes in layer l and bias neuron (the optimizer applies its own rate)
+		kernels::outerProductAccumulateBatch( nn.weightView( scratch.gradients.data(), l ), optimizer ? 1 : learningRate, neurons, nextGradients, n );
 
-		//hidden -> output weights
-		//--------------------------------------------------------------------------------------------------------
-		for (int j = 0; j <= NN->nHidden; j++)
+		//get error gradient for every hidden node of every pattern
+		if ( l > 0 )
 		{
-			for (int k = 0; k < NN->nOutput; k++)
-			{
-				//update weight
-				NN->wHiddenOutput[layer][j][k] += deltaHiddenOutput[layer][j][k];
+			MatrixView<Real> gradients = scratch.errorGradients.layer(l);
+			kernels::gemmTransposed( nextGradients, nn.weightMatrix(l), gradients, n, nn.topology[l] );
 
-				//clear delta only if using batch (previous delta is needed for momentum)
-				if (useBatch)deltaHiddenOutput[layer][j][k] = 0;
-			}
+			for ( int b = 0; b < n; b++ ) kernels::activationDerivative( nn.activation(l), neurons.row(b), gradients.row(b), nn.topology[l] );
+		}
+	}
+}
+/*******************************************************************
+* Turn the summed gradients of an update into deltas with the
+* optimizer, gradients may be the deltas themselves. Without an
+* optimizer the deltas already hold the change.
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::computeDeltas( const Real* gradients )
+{
+	if ( optimizer ) optimizer->computeDeltas( gradients, deltas.data(), (int) deltas.size() );
+}
+/*******************************************************************
+* Update weights using delta values
+********************************************************************/
+template<typename Real>
+void BasicNeuralNetworkTrainer<Real>::updateWeights()
+{
+	if (!masterWeights.empty())
+	{
+		//accumulate in double precision and round once per update
+		for (int i = 0; i < (int)deltas.size(); i++)
+		{
+			masterWeights[i] += deltas[i];
+			NN->weights[i] = (Real)masterWeights[i];
 		}
 	}
+	//weights of every layer in one pass
+	else kernels::add(NN->weights.data(), deltas.data(), (int)deltas.size());
+
+	//clear deltas only if using batch (previous delta is needed for momentum)
+	if (useBatch) std::fill(deltas.begin(), deltas.end(), 0.0);
 }
+
+template class air::BasicNeuralNetworkTrainer<float>;
+template class air::BasicNeuralNetworkTrainer<double>;
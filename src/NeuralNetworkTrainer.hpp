@@ -3,8 +3,16 @@
 #include <vector>
 #include <memory>
 #include <string>
-#include "DataEntry.hpp"
+#include <functional>
+#include <chrono>
+#include "TrainingDataSet.hpp"
+#include "DataStream.hpp"
 #include "NeuralNetwork.hpp"
+#include "Matrix.hpp"
+#include "ThreadPool.hpp"
+#include "CheckpointWriter.hpp"
+#include "WeightSnapshot.hpp"
+#include "Optimizer.hpp"
 
 //Constant Defaults!
 #define LEARNING_RATE 0.001
@@ -13,33 +21,113 @@
 #define DESIRED_ACCURACY 90  
 #define DESIRED_MSE 0.001 
 
+//loss minimised by the trainer, CrossEntropy expects Softmax or Sigmoid outputs
+enum class Loss { MSE, CrossEntropy };
+
+//learning rate over the epochs of a run, see the set...Schedule methods
+enum class Schedule { Constant, Step, Cosine, ReduceOnPlateau };
+
 /*******************************************************************
-* Basic Gradient Descent Trainer with Momentum and Batch Learning
+* Basic Gradient Descent Trainer with Momentum, Mini-Batch and
+* Batch Learning. Real is the element type of the network; with
+* master weights a float network is updated through a double copy
+* of its weights so small updates are not lost to rounding. An
+* optimizer (Adam, RMSProp, Nesterov) replaces the built-in momentum
+* update.
 ********************************************************************/
 namespace air
 {
-	class NeuralNetworkTrainer
+	template<typename Real>
+	class BasicNeuralNetworkTrainer
 	{
 	public:
-		NeuralNetworkTrainer(std::shared_ptr<NeuralNetwork> untrainedNetwork);
+		typedef BasicNeuralNetwork<Real> Network;
+		typedef BasicNeuronBatch<Real> NeuronBatch;
+		typedef BasicSnapshotPublisher<Real> Publisher;
+		typedef BasicOptimizer<Real> Optimizer;
+
+		BasicNeuralNetworkTrainer(std::shared_ptr<Network> untrainedNetwork);
 		void setTrainingParameters(double lR, double m, bool batch);
-		void setStoppingConditions(int mEpochs, double dAccuracy);
+
+		//dMSE > 0 also stops once the generalization MSE reaches it (e.g. DESIRED_MSE), 0 = no MSE goal
+		void setStoppingConditions(int mEpochs, double dAccuracy, double dMSE = 0);
+
+		//stop once the generalization MSE has not improved by more than minDelta for patience epochs (0 = never)
+		void setEarlyStopping(int patience, double minDelta = 0, bool restoreBestWeights = true);
+
+		//learning rate schedules, all start from the rate set when training starts and stay above minRate
+		void setStepSchedule(int everyEpochs, double factor, double minRate = 0);
+		void setCosineSchedule(int periodEpochs = 0, double minRate = 0);
+		void setPlateauSchedule(int patience, double factor = 0.1, double minRate = 0, double minDelta = 0);
+		void setConstantSchedule() { schedule = Schedule::Constant; }
 		void useBatchLearning(bool flag) { useBatch = flag; }
-		void enableLogging(const std::string& filename, int resolution);
+		void setBatchSize(int size);
+		void setNumThreads(int n);
+		void useMasterWeights(bool flag);
+		void setLoss(Loss l) { loss = l; }
+
+		//print the banner, progress and results to the console (errors are always printed)
+		void setVerbose(bool flag) { verbose = flag; }
+
+		//update rule, nullptr = built-in gradient descent with momentum (set before resuming from a checkpoint)
+		void setOptimizer(std::shared_ptr<Optimizer> o);
+		void enableLogging(const std::string& filename, int resolution = 1);
+
+		//checkpoint weights and training state every n epochs and/or every t seconds (0 = never), written in the background
+		void enableCheckpointing(const std::string& filename, int everyEpochs, double everySeconds = 0);
+
+		//continue training from a checkpoint written by enableCheckpointing
+		bool resumeFromCheckpoint(const std::string& filename);
+
+		//publish a weight snapshot every n epochs and at the end of training, readers never see the weights being trained
+		void publishSnapshots(std::shared_ptr<Publisher> publisher, int everyEpochs = 1);
 
 		void trainNetwork(std::shared_ptr<TrainingDataSet> tSet);
+		void trainNetwork(DataStream& stream, std::shared_ptr<TrainingDataSet> tSet = nullptr);
+
+		//results of the last run
+		long getEpochs() const { return epoch; }
+		SetStats getGeneralizationStats() const { return { generalizationSetAccuracy, generalizationSetMSE }; }
+		SetStats getValidationStats() const { return { validationSetAccuracy, validationSetMSE }; }
 
 		//private methods
 		//--------------------------------------------------------------------------------------------
 	private:
-		inline double getOutputErrorGradient(double desiredValue, double outputValue);
-		double getHiddenErrorGradient(int layer, int j);
-		void runTrainingEpoch(std::vector<std::shared_ptr<DataEntry>> trainingSet);
-		void backpropagate(std::vector<double> desiredOutputs);
+		//scratch owned by a single worker thread during mini-batch / batch training
+		class WorkerScratch
+		{
+		public:
+			WorkerScratch(const Network& nn, int capacity);
+
+			NeuronBatch neurons;
+			NeuronBatch errorGradients;
+			AlignedVector<Real> gradients;		//summed change of the worker's patterns, laid out like NN->weights
+			double incorrectPatterns;
+			double mse;
+		};
+
+		inline void getOutputErrorGradients(const double* desiredValues, const Real* outputValues, Real* gradients) const;
+		double getLearningRate() const;
+		void setLearningRate(double rate);
+		double scheduledLearningRate(double baseRate) const;
+		bool trackProgress();
+		void restoreBestWeights();
+		void trainEpochs(const std::function<void()>& runEpoch, const DataSubset* generalizationSet, const DataSubset* validationSet);
+		void runTrainingEpoch(const DataSubset& trainingSet);
+		void runStreamEpoch(DataStream& stream);
+		void trainPatterns(const DataSubset& trainingSet, double& incorrectPatterns, double& mse);
+		void backpropagate(const double* desiredOutputs);
+		void runShard(WorkerScratch& scratch, const DataSubset& trainingSet, int start, int n);
+		void backpropagateBatch(WorkerScratch& scratch, const DataSubset& trainingSet, int start, int n);
+		void createWorkers();
 		void updateWeights();
+		void computeDeltas(const Real* gradients);
+		void syncMasterWeights();
+		bool checkpointDue() const;
+		void writeCheckpoint();
 
 	private:
-		std::shared_ptr<NeuralNetwork> NN;
+		std::shared_ptr<Network> NN;
 
 		//learning parameters
 		double learningRate;					// adjusts the step size of the weight update	
@@ -51,15 +139,40 @@ namespace air
 
 		//accuracy/MSE required
 		double desiredAccuracy;
+		double desiredMSE;
 
-		//change to weights
-		//also for the layers
-		std::vector<std::vector<std::vector<double>>> deltaInputHidden;
-		std::vector<std::vector<std::vector<double>>> deltaHiddenOutput;
+		//early stopping on the generalization MSE
+		int stoppingPatience;					//epochs without improvement before stopping, 0 = off
+		double stoppingMinDelta;				//smallest decrease of the MSE that counts as an improvement
+		bool restoreBest;						//go back to the weights of the best epoch when stopping
+		double bestMSE;
+		long bestEpoch;
+		AlignedVector<Real> bestWeights;
+		AlignedVector<double> bestMasterWeights;
 
-		//error gradients
-		std::vector<std::vector<double>> hiddenErrorGradients;
-		std::vector<std::vector<double>> outputErrorGradients;
+		//learning rate schedule
+		Schedule schedule;
+		int scheduleEpochs;						//Step: epochs per step, Cosine: period (0 = maxEpochs), ReduceOnPlateau: patience
+		double scheduleFactor;					//Step and ReduceOnPlateau: factor applied to the rate
+		double minLearningRate;
+		double plateauMinDelta;
+		double plateauLearningRate;				//current rate of ReduceOnPlateau
+		double plateauBestMSE;
+		int plateauEpochs;						//epochs without improvement since the last reduction
+
+		Loss loss;
+
+		//update rule (nullptr = learning rate and momentum above)
+		std::shared_ptr<Optimizer> optimizer;
+
+		//change to weights - laid out like NN->weights, use NN->weightView
+		AlignedVector<Real> deltas;
+
+		//double precision copy of NN->weights the deltas are applied to (empty if disabled)
+		AlignedVector<double> masterWeights;
+
+		//error gradients - laid out like NN->neurons (input layer entries unused)
+		AlignedVector<Real> errorGradients;
 
 		//accuracy stats per epoch
 		double trainingSetAccuracy;
@@ -69,14 +182,50 @@ namespace air
 		double validationSetMSE;
 		double generalizationSetMSE;
 
+		//patterns of the current piece of a data stream
+		DataStore streamPiece;
+
 		//batch learning flag
 		bool useBatch;
 
+		//mini-batch size (1 = stochastic learning)
+		int batchSize;
+
+		//worker threads, each batch is split into one contiguous shard per worker
+		int numThreads;
+		std::unique_ptr<ThreadPool> pool;
+		std::vector<WorkerScratch> workers;
+		std::vector<NeuronBatch> evaluationScratch;	//one per thread for evaluating generalization/validation sets
+
+		//console output
+		bool verbose;
+
 		//log file handle
 		bool loggingEnabled;
 		std::fstream logFile;
 		int logResolution;
 		int lastEpochLogged;
+
+		//periodic checkpoints
+		std::string checkpointFilename;
+		int checkpointEpochs;
+		double checkpointSeconds;
+		std::chrono::steady_clock::time_point lastCheckpoint;
+		std::unique_ptr<CheckpointWriter> checkpointWriter;
+
+		//weight snapshots for concurrent inference
+		std::shared_ptr<Publisher> publisher;
+		int publishEpochs;
+
+		//state restored by resumeFromCheckpoint
+		bool resumed;
+		std::string streamRngState;
+
+		//stream being trained on (nullptr if training on a data set)
+		DataStream* activeStream;
 	};
+
+	typedef BasicNeuralNetworkTrainer<double> NeuralNetworkTrainer;
+	typedef BasicNeuralNetworkTrainer<float> NeuralNetworkTrainerF;
 }
 
@@ -0,0 +1,184 @@
+#include "Optimizer.hpp"
+#include <cstring>
+#include <cstdint>
+#include <sstream>
+#include <math.h>
+#include "Kernels.hpp"
+
+using namespace air;
+
+namespace
+{
+	/*******************************************************************
+	* State blocks are the update count followed by the state buffers
+	* back to back in the element type of the trainer
+	********************************************************************/
+	template<typename Real>
+	std::vector<char> packState(std::int64_t count, const std::vector<const AlignedVector<Real>*>& buffers)
+	{
+		std::size_t size = sizeof(count);
+		for (auto b : buffers) size += b->size() * sizeof(Real);
+
+		std::vector<char> state(size);
+		char* p = state.data();
+		std::memcpy(p, &count, sizeof(count));
+		p += sizeof(count);
+		for (auto b : buffers)
+		{
+			std::memcpy(p, b->data(), b->size() * sizeof(Real));
+			p += b->size() * sizeof(Real);
+		}
+		return state;
+	}
+
+	//buffers have to be sized already, fails if the block does not match
+	template<typename Real>
+	bool unpackState(const char* data, std::size_t size, std::int64_t& count, const std::vector<AlignedVector<Real>*>& buffers)
+	{
+		std::size_t expected = sizeof(count);
+		for (auto b : buffers) expected += b->size() * sizeof(Real);
+		if (size != expected) return false;
+
+		std::memcpy(&count, data, sizeof(count));
+		data += sizeof(count);
+		for (auto b : buffers)
+		{
+			std::memcpy(b->data(), data, b->size() * sizeof(Real));
+			data += b->size() * sizeof(Real);
+		}
+		return true;
+	}
+}
+
+template<typename Real>
+BasicNesterovOptimizer<Real>::BasicNesterovOptimizer(double lR, double m) : learningRate(lR), momentum(m)
+{
+}
+
+template<typename Real>
+void BasicNesterovOptimizer<Real>::reset(int n)
+{
+	velocity.assign(n, 0);
+}
+
+template<typename Real>
+void BasicNesterovOptimizer<Real>::computeDeltas(const Real* gradients, Real* deltas, int n)
+{
+	kernels::nesterovUpdate(deltas, velocity.data(), gradients, n, (Real)learningRate, (Real)momentum);
+}
+
+template<typename Real>
+std::string BasicNesterovOptimizer<Real>::describe() const
+{
+	std::ostringstream s;
+	s << "Nesterov (LR: " << learningRate << ", Momentum: " << momentum << ")";
+	return s.str();
+}
+
+template<typename Real>
+std::vector<char> BasicNesterovOptimizer<Real>::saveState() const
+{
+	return packState<Real>(0, { &velocity });
+}
+
+template<typename Real>
+bool BasicNesterovOptimizer<Real>::loadState(const char* data, std::size_t size)
+{
+	std::int64_t count;
+	return unpackState<Real>(data, size, count, { &velocity });
+}
+
+template<typename Real>
+BasicRMSPropOptimizer<Real>::BasicRMSPropOptimizer(double lR, double r, double e) : learningRate(lR), rho(r), epsilon(e)
+{
+}
+
+template<typename Real>
+void BasicRMSPropOptimizer<Real>::reset(int n)
+{
+	meanSquare.assign(n, 0);
+}
+
+template<typename Real>
+void BasicRMSPropOptimizer<Real>::computeDeltas(const Real* gradients, Real* deltas, int n)
+{
+	kernels::rmspropUpdate(deltas, meanSquare.data(), gradients, n, (Real)rho, (Real)learningRate, (Real)epsilon);
+}
+
+template<typename Real>
+std::string BasicRMSPropOptimizer<Real>::describe() const
+{
+	std::ostringstream s;
+	s << "RMSProp (LR: " << learningRate << ", Rho: " << rho << ")";
+	return s.str();
+}
+
+template<typename Real>
+std::vector<char> BasicRMSPropOptimizer<Real>::saveState() const
+{
+	return packState<Real>(0, { &meanSquare });
+}
+
+template<typename Real>
+bool BasicRMSPropOptimizer<Real>::loadState(const char* data, std::size_t size)
+{
+	std::int64_t count;
+	return unpackState<Real>(data, size, count, { &meanSquare });
+}
+
+template<typename Real>
+BasicAdamOptimizer<Real>::BasicAdamOptimizer(double lR, double b1, double b2, double e) : learningRate(lR), beta1(b1), beta2(b2), epsilon(e), timeStep(0)
+{
+}
+
+template<typename Real>
+void BasicAdamOptimizer<Real>::reset(int n)
+{
+	timeStep = 0;
+	mean.assign(n, 0);
+	variance.assign(n, 0);
+}
+
+/*******************************************************************
+* The bias corrections of both averages only depend on the time
+* step, so they are folded into a single step size
+********************************************************************/
+template<typename Real>
+void BasicAdamOptimizer<Real>::computeDeltas(const Real* gradients, Real* deltas, int n)
+{
+	timeStep++;
+	double step = learningRate * sqrt(1 - pow(beta2, (double)timeStep)) / (1 - pow(beta1, (double)timeStep));
+
+	kernels::adamUpdate(deltas, mean.data(), variance.data(), gradients, n, (Real)beta1, (Real)beta2, (Real)step, (Real)epsilon);
+}
+
+template<typename Real>
+std::string BasicAdamOptimizer<Real>::describe() const
+{
+	std::ostringstream s;
+	s << "Adam (LR: " << learningRate << ", Beta1: " << beta1 << ", Beta2: " << beta2 << ")";
+	return s.str();
+}
+
+template<typename Real>
+std::vector<char> BasicAdamOptimizer<Real>::saveState() const
+{
+	return packState<Real>(timeStep, { &mean, &variance });
+}
+
+template<typename Real>
+bool BasicAdamOptimizer<Real>::loadState(const char* data, std::size_t size)
+{
+	std::int64_t count;
+	if (!unpackState<Real>(data, size, count, { &mean, &variance })) return false;
+
+	timeStep = count;
+	return true;
+}
+
+template class air::BasicNesterovOptimizer<float>;
+template class air::BasicNesterovOptimizer<double>;
+template class air::BasicRMSPropOptimizer<float>;
+template class air::BasicRMSPropOptimizer<double>;
+template class air::BasicAdamOptimizer<float>;
+template class air::BasicAdamOptimizer<double>;
@@ -0,0 +1,132 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "Matrix.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Weight update rule of the trainer. Once per update (pattern,
+	* mini-batch or batch) it turns the summed gradients of the weights
+	* into the deltas added to them. Per weight state lives in flat
+	* buffers laid out like the network's weights and every update is a
+	* single fused kernel pass over them (see Kernels.hpp).
+	*
+	* Without an optimizer the trainer keeps its built-in gradient
+	* descent with momentum (setTrainingParameters).
+	********************************************************************/
+	template<typename Real>
+	class BasicOptimizer
+	{
+	public:
+		virtual ~BasicOptimizer() {}
+
+		//size the state for n weights and clear it
+		virtual void reset(int n) = 0;
+
+		//deltas of all n weights from their summed gradients (pointing downhill, learning rate not applied),
+		//gradients may be the deltas buffer itself
+		virtual void computeDeltas(const Real* gradients, Real* deltas, int n) = 0;
+
+		//name and parameters for the training banner
+		virtual std::string describe() const = 0;
+
+		//step size, changed by the trainer's learning rate schedule
+		virtual double getLearningRate() const = 0;
+		virtual void setLearningRate(double rate) = 0;
+
+		//state for checkpoints, loadState fails if the size does not match
+		virtual std::vector<char> saveState() const = 0;
+		virtual bool loadState(const char* data, std::size_t size) = 0;
+	};
+
+	/*******************************************************************
+	* Gradient descent with Nesterov momentum
+	********************************************************************/
+	template<typename Real>
+	class BasicNesterovOptimizer : public BasicOptimizer<Real>
+	{
+	public:
+		BasicNesterovOptimizer(double learningRate = 0.001, double momentum = 0.9);
+
+		void reset(int n) override;
+		void computeDeltas(const Real* gradients, Real* deltas, int n) override;
+		std::string describe() const override;
+		double getLearningRate() const override { return learningRate; }
+		void setLearningRate(double rate) override { learningRate = rate; }
+		std::vector<char> saveState() const override;
+		bool loadState(const char* data, std::size_t size) override;
+
+	private:
+		double learningRate;
+		double momentum;
+
+		AlignedVector<Real> velocity;
+	};
+
+	/*******************************************************************
+	* RMSProp - step size per weight from a running average of its
+	* squared gradients
+	********************************************************************/
+	template<typename Real>
+	class BasicRMSPropOptimizer : public BasicOptimizer<Real>
+	{
+	public:
+		BasicRMSPropOptimizer(double learningRate = 0.001, double rho = 0.9, double epsilon = 1e-8);
+
+		void reset(int n) override;
+		void computeDeltas(const Real* gradients, Real* deltas, int n) override;
+		std::string describe() const override;
+		double getLearningRate() const override { return learningRate; }
+		void setLearningRate(double rate) override { learningRate = rate; }
+		std::vector<char> saveState() const override;
+		bool loadState(const char* data, std::size_t size) override;
+
+	private:
+		double learningRate;
+		double rho;
+		double epsilon;
+
+		AlignedVector<Real> meanSquare;
+	};
+
+	/*******************************************************************
+	* Adam - running averages of gradients and squared gradients with
+	* bias correction (Kingma & Ba, with epsilon added after the
+	* correction is folded into the step size)
+	********************************************************************/
+	template<typename Real>
+	class BasicAdamOptimizer : public BasicOptimizer<Real>
+	{
+	public:
+		BasicAdamOptimizer(double learningRate = 0.001, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
+
+		void reset(int n) override;
+		void computeDeltas(const Real* gradients, Real* deltas, int n) override;
+		std::string describe() const override;
+		double getLearningRate() const override { return learningRate; }
+		void setLearningRate(double rate) override { learningRate = rate; }
+		std::vector<char> saveState() const override;
+		bool loadState(const char* data, std::size_t size) override;
+
+	private:
+		double learningRate;
+		double beta1;
+		double beta2;
+		double epsilon;
+
+		long long timeStep;					//updates done so far
+		AlignedVector<Real> mean;
+		AlignedVector<Real> variance;
+	};
+
+	typedef BasicOptimizer<double> Optimizer;
+	typedef BasicOptimizer<float> OptimizerF;
+	typedef BasicNesterovOptimizer<double> NesterovOptimizer;
+	typedef BasicNesterovOptimizer<float> NesterovOptimizerF;
+	typedef BasicRMSPropOptimizer<double> RMSPropOptimizer;
+	typedef BasicRMSPropOptimizer<float> RMSPropOptimizerF;
+	typedef BasicAdamOptimizer<double> AdamOptimizer;
+	typedef BasicAdamOptimizer<float> AdamOptimizerF;
+}
@@ -0,0 +1,159 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "DataReader.hpp"
+#include "NeuralNetwork.hpp"
+#include "NeuralNetworkTrainer.hpp"
+#include "QuantizedNetwork.hpp"
+#include "Kernels.hpp"
+
+using namespace air;
+
+/*******************************************************************
+* Float vs int8 inference: checks the int8 kernels of every
+* instruction set against the scalar ones (integer sums must match
+* exactly), then quantizes a trained network and reports model size,
+* latency and the accuracy difference on the validation set.
+*
+* usage: air-bench-quantized [data file] [weights.airw]
+* without a weight file a 16-20-3 network is trained for a few epochs
+********************************************************************/
+
+//epochs trained when no weight file is given
+static const int TRAINING_EPOCHS = 50;
+
+//repetitions of every timed run, the fastest one counts
+static const int REPETITIONS = 5;
+
+template<typename F>
+static double fastestRun(F f)
+{
+	double best = 1e300;
+	for (int r = 0; r < REPETITIONS; r++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		f();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+/*******************************************************************
+* Integer sums of random matrices (odd column counts exercise the
+* tails) on every instruction set the CPU supports
+********************************************************************/
+static bool checkKernels()
+{
+	bool identical = true;
+	const int sizes[][2] = { { 18, 20 }, { 22, 3 }, { 64, 37 }, { 258, 129 } };
+	const kernels::Isa isas[] = { kernels::Isa::SSE2, kernels::Isa::AVX2, kernels::Isa::AVX512 };
+
+	for (auto& size : sizes)
+	{
+		int rows = size[0], cols = size[1];
+		std::vector<std::int8_t> x(rows), w(rows * cols);
+		std::vector<std::int32_t> expected(cols), y(cols);
+		for (auto& v : x) v = (std::int8_t)(rand() % 255 - 127);
+		for (auto& v : w) v = (std::int8_t)(rand() % 255 - 127);
+
+		kernels::scalarKernels<float>()->gemvInt8(x.data(), w.data(), rows, cols, expected.data());
+		for (kernels::Isa isa : isas)
+		{
+			if (!kernels::selectIsa(isa)) continue;
+
+			kernels::gemvInt8(x.data(), w.data(), rows, cols, y.data());
+			if (y != expected)
+			{
+				std::cout << " " << kernels::table<float>().name << " int8 sums differ from Scalar for " << rows << " x " << cols << std::endl;
+				identical = false;
+			}
+		}
+	}
+
+	kernels::selectIsa(kernels::detectIsa());
+	return identical;
+}
+
+int main(int argc, char** argv)
+{
+	std::string dataFile = argc > 1 ? argv[1] : "data.csv";
+
+	DataReader reader;
+	if (!reader.loadDataFile(dataFile, 16, 3)) return 1;
+	reader.setCreationApproach(STATIC, 10);
+	std::shared_ptr<TrainingDataSet> set = reader.getTrainingDataSet();
+
+	srand(1);
+	auto nn = std::make_shared<NeuralNetwork>(std::vector<int>{ 16, 20, 3 });
+	if (argc > 2)
+	{
+		if (!nn->loadCheckpoint(argv[2])) return 1;
+	}
+	else
+	{
+		NeuralNetworkTrainer trainer(nn);
+		trainer.setStoppingConditions(TRAINING_EPOCHS, 100);
+		trainer.trainNetwork(set);
+	}
+
+	bool identical = checkKernels();
+
+	NeuralNetworkF nnF(nn->topology);
+	std::transform(nn->weights.begin(), nn->weights.end(), nnF.weights.begin(), [](double w) { return (float)w; });
+	QuantizedNetwork qn(*nn);
+
+	const DataSubset& validation = set->validationSet;
+	std::cout << std::endl << "Validation set, " << validation.size() << " patterns, " << kernels::table<double>().name << " kernels" << std::endl;
+
+	//accuracy, MSE and time per pattern of each representation
+	std::vector<double> doubleOutputs(validation.size() * nn->nOutput);
+	std::vector<float> floatOutputs(validation.size() * nn->nOutput), int8Outputs(validation.size() * nn->nOutput);
+
+	std::vector<NeuronBatch> scratch(1, NeuronBatch(nn->topology, EVALUATION_BATCH_SIZE));
+	std::vector<NeuronBatchF> scratchF(1, NeuronBatchF(nnF.topology, EVALUATION_BATCH_SIZE));
+	SetStats doubleStats = nn->evaluateSet(validation, scratch);
+	SetStats floatStats = nnF.evaluateSet(validation, scratchF);
+	SetStats int8Stats = qn.evaluateSet(validation);
+
+	double doubleTime = fastestRun([&] { for (int i = 0; i < validation.size(); i++) nn->predict(validation.pattern(i), &doubleOutputs[i * nn->nOutput]); });
+	double floatTime = fastestRun([&] { for (int i = 0; i < validation.size(); i++) nnF.predict(validation.pattern(i), &floatOutputs[i * nn->nOutput]); });
+	double int8Time = fastestRun([&] { for (int i = 0; i < validation.size(); i++) qn.predict(validation.pattern(i), &int8Outputs[i * nn->nOutput]); });
+
+	auto report = [&](const char* type, const SetStats& stats, std::size_t bytes, double time)
+	{
+		std::cout << " " << type << ": accuracy " << stats.accuracy << "%, MSE " << stats.mse << ", " << bytes << " weight bytes, "
+			<< time / validation.size() * 1e9 << " ns per pattern" << std::endl;
+	};
+	report("double", doubleStats, nn->weights.size() * sizeof(double), doubleTime);
+	report("float ", floatStats, nnF.weights.size() * sizeof(float), floatTime);
+	report("int8  ", int8Stats, qn.weightBytes(), int8Time);
+
+	//how far the int8 outputs are from the float ones
+	double maxDifference = 0;
+	int changed = 0;
+	for (int i = 0; i < validation.size(); i++)
+	{
+		bool differs = false;
+		for (int k = 0; k < nn->nOutput; k++)
+		{
+			float f = floatOutputs[i * nn->nOutput + k], q = int8Outputs[i * nn->nOutput + k];
+			maxDifference = std::max(maxDifference, (double)std::fabs(f - q));
+			if (nnF.clampOutput(f) != qn.clampOutput(q)) differs = true;
+		}
+		if (differs) changed++;
+	}
+
+	std::cout << " int8 vs float: accuracy " << int8Stats.accuracy - floatStats.accuracy << " points, max output difference " << maxDifference << ", "
+		<< changed << " of " << validation.size() << " patterns classified differently" << std::endl;
+
+	if (!identical)
+	{
+		std::cout << std::endl << "Error - int8 kernels do not match the scalar ones" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+#include "QuantizedNetwork.hpp"
+#include <algorithm>
+#include <math.h>
+
+using namespace air;
+
+//largest magnitude of a symmetric int8 value
+static const int INT8_RANGE = 127;
+
+//nearest int8 of v / scale, clamped to +-INT8_RANGE (plain arithmetic so layer loops vectorise)
+static inline std::int8_t quantizeValue(float v, float inverseScale)
+{
+	float q = std::max(-(float)INT8_RANGE, std::min((float)INT8_RANGE, v * inverseScale));
+	return (std::int8_t)(int)((q + 12582912.0f) - 12582912.0f);
+}
+
+QuantizedNetwork::QuantizedNetwork() : nInput(0), nOutput(0), activationMode(ActivationMode::Exact)
+{
+}
+
+template<typename Real>
+QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<Real>& nn) : QuantizedNetwork()
+{
+	quantize(nn);
+}
+
+template<typename Real>
+void QuantizedNetwork::quantize(const BasicNeuralNetwork<Real>& nn)
+{
+	nInput = nn.nInput;
+	nOutput = nn.nOutput;
+	topology = nn.topology;
+	activationMode = nn.getActivationMode();
+
+	//lay out neuron and packed weight buffers
+	int nNeurons = 0, nWeights = 0, maxRows = 0, maxCols = 0;
+	neuronOffsets.clear();
+	weightOffsets.clear();
+	for (int l = 0; l < (int)topology.size(); l++)
+	{
+		neuronOffsets.push_back(nNeurons);
+		nNeurons += topology[l] + 1;
+
+		if (l < numWeightLayers())
+		{
+			weightOffsets.push_back(nWeights);
+			nWeights += paddedRows(l) * topology[l + 1];
+			maxRows = std::max(maxRows, paddedRows(l));
+			maxCols = std::max(maxCols, topology[l + 1]);
+		}
+	}
+
+	neurons = AlignedVector<float>(nNeurons, 0);
+	weights = AlignedVector<std::int8_t>(nWeights, 0);
+	quantizedNeurons = AlignedVector<std::int8_t>(maxRows, 0);
+	sums = AlignedVector<std::int32_t>(maxCols, 0);
+
+	//create input and hidden bias neurons
+	for (int l = 0; l < numWeightLayers(); l++) layerNeurons(l)[topology[l]] = -1;
+
+	//quantize every weight layer on its own range
+	//--------------------------------------------------------------------------------------------------------
+	scales.clear();
+	activations.clear();
+	for (int l = 0; l < numWeightLayers(); l++)
+	{
+		MatrixView<const Real> w = nn.weightMatrix(l);
+
+		double largest = 0;
+		for (int i = 0; i < w.size(); i++) largest = std::max(largest, fabs((double)w.data[i]));
+		double scale = largest > 0 ? largest / INT8_RANGE : 1;
+
+		std::int8_t* q = weights.data() + weightOffsets[l];
+		for (int i = 0; i < w.rows; i++)
+		{
+			for (int j = 0; j < w.cols; j++) q[kernels::packedInt8Index(i, j, w.cols)] = quantizeValue((float)w(i, j), (float)(1 / scale));
+		}
+
+		scales.push_back((float)scale);
+		activations.push_back(nn.activation(l + 1));
+	}
+}
+
+/*******************************************************************
+* Clamped 0 / 1 / -1 results of a pattern, see
+* NeuralNetwork::feedForwardPattern
+********************************************************************/
+std::vector<int> QuantizedNetwork::feedForwardPattern(const std::vector<double>& pattern)
+{
+	std::vector<int> results(nOutput);
+	classify(pattern.data(), results.data());
+
+	return results;
+}
+
+void QuantizedNetwork::predict(const double* pattern, float* outputs)
+{
+	feedForward(pattern);
+
+	const float* output = layerNeurons(numWeightLayers());
+	std::copy(output, output + nOutput, outputs);
+}
+
+void QuantizedNetwork::classify(const double* pattern, int* results)
+{
+	feedForward(pattern);
+
+	const float* output = layerNeurons(numWeightLayers());
+	for (int k = 0; k < nOutput; k++) results[k] = clampOutput(output[k]);
+}
+
+/*******************************************************************
+* Accuracy and MSE of a set, computed as in NeuralNetwork::evaluateSet
+********************************************************************/
+SetStats QuantizedNetwork::evaluateSet(const DataSubset& set)
+{
+	double incorrectResults = 0, mse = 0;
+	const float* output = layerNeurons(numWeightLayers());
+
+	for (int tp = 0; tp < set.size(); tp++)
+	{
+		feedForward(set.pattern(tp));
+
+		//check all outputs against desired output values
+		const double* target = set.target(tp);
+		bool correctResult = true;
+		for (int k = 0; k < nOutput; k++)
+		{
+			if (clampOutput(output[k]) != target[k]) correctResult = false;
+			mse += pow((output[k] - target[k]), 2);
+		}
+		if (!correctResult) incorrectResults++;
+	}
+
+	SetStats stats;
+	stats.accuracy = 100 - (incorrectResults / set.size() * 100);
+	stats.mse = mse / (nOutput * set.size());
+	return stats;
+}
+
+int QuantizedNetwork::clampOutput(float x) const
+{
+	if (x < 0.1) return 0;
+	else if (x > 0.9) return 1;
+	else return -1;
+}
+
+void QuantizedNetwork::feedForward(const double* pattern)
+{
+	float* input = layerNeurons(0);
+	for (int i = 0; i < nInput; i++) input[i] = (float)pattern[i];
+
+	//Calculate every following layer from the previous one - include bias neuron
+	//--------------------------------------------------------------------------------------------------------
+	for (int l = 0; l < numWeightLayers(); l++)
+	{
+		const float* x = layerNeurons(l);
+		float* next = layerNeurons(l + 1);
+		int rows = topology[l] + 1;
+
+		//quantize the layer and its bias neuron on their own range (the padding row of the weights is 0)
+		float largest = 0;
+		for (int i = 0; i < rows; i++) largest = std::max(largest, fabsf(x[i]));
+		float scale = largest > 0 ? largest / INT8_RANGE : 1, inverseScale = 1 / scale;
+		for (int i = 0; i < rows; i++) quantizedNeurons[i] = quantizeValue(x[i], inverseScale);
+
+		//integer weighted sums, scaled back to float
+		kernels::gemvInt8(quantizedNeurons.data(), weights.data() + weightOffsets[l], paddedRows(l), topology[l + 1], sums.data());
+
+		float s = scale * scales[l];
+		for (int j = 0; j < topology[l + 1]; j++) next[j] = sums[j] * s;
+
+		//set to result of the activation function (bias neuron is left untouched)
+		Activation a = activations[l];
+		if (a == Activation::Sigmoid && activationMode == ActivationMode::Fast) kernels::sigmoidFast(next, topology[l + 1]);
+		else kernels::activate(a, next, topology[l + 1]);
+	}
+}
+
+template QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<float>&);
+template QuantizedNetwork::QuantizedNetwork(const BasicNeuralNetwork<double>&);
+template void QuantizedNetwork::quantize(const BasicNeuralNetwork<float>&);
+template void QuantizedNetwork::quantize(const BasicNeuralNetwork<double>&);
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "DataStore.hpp"
+#include "Matrix.hpp"
+#include "Kernels.hpp"
+#include "NeuralNetwork.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Post-training int8 copy of a trained network for inference. Every
+	* weight layer is quantized symmetrically with its own scale
+	* (largest |weight| / 127), so weights take a byte instead of 4 or 8.
+	* Each layer's neurons are quantized the same way on the fly, the
+	* weighted sums run in 32 bit integers (kernels::gemvInt8) and are
+	* scaled back to float before the layer's activation function.
+	*
+	* Results follow feedForwardPattern / predict / classify of
+	* NeuralNetwork within the quantization error; air-bench-quantized
+	* reports the accuracy difference on the validation set.
+	********************************************************************/
+	class QuantizedNetwork
+	{
+	public:
+		QuantizedNetwork();
+
+		template<typename Real>
+		explicit QuantizedNetwork(const BasicNeuralNetwork<Real>& nn);
+
+		//replace the network by a quantized copy of nn (weights, activations and activation mode)
+		template<typename Real>
+		void quantize(const BasicNeuralNetwork<Real>& nn);
+
+		std::vector<int> feedForwardPattern(const std::vector<double>& pattern);
+
+		//single pattern inference on the network's own buffers, never allocates (not thread safe)
+		void predict(const double* pattern, float* outputs);
+		void classify(const double* pattern, int* results);
+
+		SetStats evaluateSet(const DataSubset& set);
+		int clampOutput(float x) const;
+
+		int numWeightLayers() const { return (int)topology.size() - 1; }
+
+		//bytes taken by the int8 weights and their scales
+		std::size_t weightBytes() const { return weights.size() * sizeof(std::int8_t) + scales.size() * sizeof(float); }
+
+	private:
+		void feedForward(const double* pattern);
+
+		//weight rows of layer l (with bias) rounded up to the row pairs of gemvInt8
+		int paddedRows(int l) const { return (topology[l] + 2) & ~1; }
+		float* layerNeurons(int l) { return neurons.data() + neuronOffsets[l]; }
+
+	public:
+		//number of neurons
+		int nInput, nOutput;
+		std::vector<int> topology;				//neurons per layer (without bias): input, hidden..., output
+
+		//weights - one paddedRows(l) x topology[l + 1] matrix per layer packed for gemvInt8, padding rows are 0
+		AlignedVector<std::int8_t> weights;
+		std::vector<int> weightOffsets;			//start of each weight matrix in weights
+		std::vector<float> scales;				//real weight = scale * int8 weight, one per weight layer
+
+	private:
+		std::vector<Activation> activations;	//one per weight layer, of the layer it feeds
+		ActivationMode activationMode;
+
+		//float neurons of all layers back to back, each followed by its bias neuron
+		AlignedVector<float> neurons;
+		std::vector<int> neuronOffsets;
+
+		//quantized neurons of the layer being fed and its integer sums
+		AlignedVector<std::int8_t> quantizedNeurons;
+		AlignedVector<std::int32_t> sums;
+	};
+}
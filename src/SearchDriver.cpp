@@ -0,0 +1,123 @@
+#include "DataReader.hpp"
+#include "HyperparameterSearch.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace air;
+
+/*******************************************************************
+* Hyperparameter search - trains every combination (or --random n
+* random combinations) of the listed values in parallel on one copy
+* of the data set and writes the ranked results
+*
+* usage: air-search <data file> <inputs> <targets> [options]
+*   --hidden 10,20,40     neurons per hidden layer (required)
+*   --layers 1,2          hidden layers (default 1)
+*   --lr 0.001,0.01       learning rates
+*   --momentum 0.5,0.9    momenta
+*   --batch 1,32          mini-batch sizes (default 1)
+*   --random n            n random trials instead of the full grid
+*   --epochs n            max epochs per trial (default 1500)
+*   --accuracy a          desired accuracy per trial (default 90)
+*   --threads n           trials trained at once (default one per hardware thread)
+*   --seed n              first weight seed (default 1)
+*   --top n               rows of the printed table (default all)
+*   --out file.csv        ranked results (default search.csv)
+********************************************************************/
+
+//comma separated list of values, false if a value does not parse
+template<typename T>
+static bool parseList(const std::string& text, std::vector<T>& values)
+{
+	values.clear();
+	std::istringstream s(text);
+	std::string item;
+	while (std::getline(s, item, ','))
+	{
+		std::istringstream is(item);
+		T v;
+		if (!(is >> v)) return false;
+		values.push_back(v);
+	}
+	return !values.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 4)
+	{
+		std::cout << "usage: " << argv[0] << " <data file> <inputs> <targets> [--hidden 10,20] [--layers 1,2] [--lr 0.001,0.01] [--momentum 0.5,0.9] [--batch 1,32]"
+			<< " [--random n] [--epochs n] [--accuracy a] [--threads n] [--seed n] [--top n] [--out file.csv]" << std::endl;
+		return 1;
+	}
+
+	int nInputs = atoi(argv[2]);
+	int nTargets = atoi(argv[3]);
+	if (nInputs <= 0 || nTargets <= 0)
+	{
+		std::cout << "Error - inputs and targets have to be positive" << std::endl;
+		return 1;
+	}
+
+	SearchSpace space;
+	int randomTrials = 0, maxEpochs = MAX_EPOCHS, numThreads = 0, top = 0;
+	double desiredAccuracy = DESIRED_ACCURACY;
+	unsigned int seed = 1;
+	std::string resultsFile = "search.csv";
+
+	for (int i = 4; i < argc; i += 2)
+	{
+		std::string option = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cout << "Error - option " << option << " needs a value" << std::endl;
+			return 1;
+		}
+		std::string value = argv[i + 1];
+
+		bool valid = true;
+		if (option == "--hidden") valid = parseList(value, space.hiddenNeurons);
+		else if (option == "--layers") valid = parseList(value, space.hiddenLayers);
+		else if (option == "--lr") valid = parseList(value, space.learningRates);
+		else if (option == "--momentum") valid = parseList(value, space.momenta);
+		else if (option == "--batch") valid = parseList(value, space.batchSizes);
+		else if (option == "--random") randomTrials = atoi(value.c_str());
+		else if (option == "--epochs") maxEpochs = atoi(value.c_str());
+		else if (option == "--accuracy") desiredAccuracy = atof(value.c_str());
+		else if (option == "--threads") numThreads = atoi(value.c_str());
+		else if (option == "--seed") seed = (unsigned int)strtoul(value.c_str(), nullptr, 10);
+		else if (option == "--top") top = atoi(value.c_str());
+		else if (option == "--out") resultsFile = value;
+		else
+		{
+			std::cout << "Error - unknown option " << option << std::endl;
+			return 1;
+		}
+
+		if (!valid)
+		{
+			std::cout << "Error - invalid value list for " << option << ": " << value << std::endl;
+			return 1;
+		}
+	}
+
+	//one data set shared by all trials
+	DataReader reader;
+	if (!reader.loadDataFile(argv[1], nInputs, nTargets)) return 1;
+	reader.setCreationApproach(STATIC, 10);
+
+	HyperparameterSearch search(reader.getTrainingDataSet());
+	search.setStoppingConditions(maxEpochs, desiredAccuracy);
+	search.setNumThreads(numThreads);
+	search.setSeed(seed);
+
+	std::vector<SearchTrial> trials = randomTrials > 0 ? search.randomTrials(space, randomTrials) : search.gridTrials(space);
+	if (trials.empty()) return 1;
+
+	trials = search.run(trials);
+	HyperparameterSearch::printResults(trials, top);
+	return HyperparameterSearch::saveResults(resultsFile, trials) ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <string>
+#include <utility>
+#include <iostream>
+#include "NeuralNetwork.hpp"
+#include "WeightFile.hpp"
+#include "Kernels.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Inference-only network with a topology fixed at compile time, e.g.
+	* StaticNetwork<16, 20, 3>. Weights live in a std::array in the same
+	* order as NeuralNetwork's, so it loads the same checkpoints; every
+	* loop bound is a constant the compiler unrolls and vectorises, and
+	* a query only uses the stack. Activations are the same kernels as
+	* in NeuralNetwork, results match it on the Scalar instruction set.
+	********************************************************************/
+	template<typename Real, int... Layers>
+	class BasicStaticNetwork
+	{
+	public:
+		static_assert(sizeof...(Layers) >= 2, "a network needs an input and an output layer");
+
+		typedef Real value_type;
+
+		static constexpr int NUM_LAYERS = (int)sizeof...(Layers);
+		static constexpr int NUM_WEIGHT_LAYERS = NUM_LAYERS - 1;
+		static constexpr std::array<int, sizeof...(Layers)> TOPOLOGY = { { Layers... } };
+		static constexpr int N_INPUT = TOPOLOGY[0];
+		static constexpr int N_OUTPUT = TOPOLOGY[NUM_LAYERS - 1];
+
+	private:
+		//start of every weight matrix and neuron layer (each followed by its bias neuron)
+		static constexpr std::array<int, sizeof...(Layers)> offsets(bool weights)
+		{
+			std::array<int, sizeof...(Layers)> o = {};
+			for (int l = 1; l < NUM_LAYERS; l++) o[l] = o[l - 1] + (TOPOLOGY[l - 1] + 1) * (weights ? TOPOLOGY[l] : 1);
+			return o;
+		}
+
+		static constexpr std::array<int, sizeof...(Layers)> WEIGHT_OFFSETS = offsets(true);
+		static constexpr std::array<int, sizeof...(Layers)> NEURON_OFFSETS = offsets(false);
+
+	public:
+		static constexpr int NUM_WEIGHTS = WEIGHT_OFFSETS[NUM_LAYERS - 1];
+		static constexpr int NUM_NEURONS = NEURON_OFFSETS[NUM_LAYERS - 1] + N_OUTPUT + 1;
+
+		BasicStaticNetwork() : weights(), activationMode(ActivationMode::Exact)
+		{
+			activations.fill(Activation::Sigmoid);
+		}
+
+		/*******************************************************************
+		* Take over weights, activations and activation mode of a trained
+		* network of the same topology (either element type)
+		********************************************************************/
+		template<typename R>
+		bool load(const BasicNeuralNetwork<R>& nn)
+		{
+			if (!matches(nn.topology, nn.weights.size()))
+			{
+				std::cout << std::endl << "Error - Topology of the network does not match the static network" << std::endl;
+				return false;
+			}
+
+			for (int i = 0; i < NUM_WEIGHTS; i++) weights[i] = (Real)nn.weights[i];
+			for (int l = 0; l < NUM_WEIGHT_LAYERS; l++) activations[l] = nn.activation(l + 1);
+			activationMode = nn.getActivationMode();
+			return true;
+		}
+
+		//weights of a binary checkpoint (see WeightFile.hpp), activations are left as they are
+		bool loadCheckpoint(const std::string& filename)
+		{
+			WeightFile file;
+			if (!readWeightFile(filename, file)) return false;
+
+			if (!matches(file.topology, file.header.numWeights))
+			{
+				std::cout << std::endl << "Error - Topology of checkpoint '" << filename << "' does not match the static network" << std::endl;
+				return false;
+			}
+
+			convertValues(file.weights(), file.dataType(), NUM_WEIGHTS, weights.data());
+			return true;
+		}
+
+		void setActivation(int layer, Activation a) { activations[layer - 1] = a; }
+		void setActivationMode(ActivationMode mode) { activationMode = mode; }
+
+		//nOutput raw outputs of a pattern of N_INPUT values
+		void predict(const double* pattern, Real* outputs) const
+		{
+			alignas(BUFFER_ALIGNMENT) std::array<Real, NUM_NEURONS> neurons;
+			feedForward(pattern, neurons);
+
+			const Real* output = neurons.data() + NEURON_OFFSETS[NUM_LAYERS - 1];
+			for (int k = 0; k < N_OUTPUT; k++) outputs[k] = output[k];
+		}
+
+		//clamped 0 / 1 / -1 results, see NeuralNetwork::clampOutput
+		void classify(const double* pattern, int* results) const
+		{
+			alignas(BUFFER_ALIGNMENT) std::array<Real, NUM_NEURONS> neurons;
+			feedForward(pattern, neurons);
+
+			const Real* output = neurons.data() + NEURON_OFFSETS[NUM_LAYERS - 1];
+			for (int k = 0; k < N_OUTPUT; k++) results[k] = output[k] < 0.1 ? 0 : (output[k] > 0.9 ? 1 : -1);
+		}
+
+	private:
+		template<typename Topology, typename Size>
+		static bool matches(const Topology& topology, Size numWeights)
+		{
+			if ((int)topology.size() != NUM_LAYERS || (long long)numWeights != NUM_WEIGHTS) return false;
+			for (int l = 0; l < NUM_LAYERS; l++) if (topology[l] != TOPOLOGY[l]) return false;
+			return true;
+		}
+
+		void feedForward(const double* pattern, std::array<Real, NUM_NEURONS>& neurons) const
+		{
+			for (int i = 0; i < N_INPUT; i++) neurons[i] = (Real)pattern[i];
+			feedLayers(neurons, std::make_index_sequence<NUM_WEIGHT_LAYERS>());
+		}
+
+		template<std::size_t... L>
+		void feedLayers(std::array<Real, NUM_NEURONS>& neurons, std::index_sequence<L...>) const
+		{
+			(feedLayer<L>(neurons), ...);
+		}
+
+		/*******************************************************************
+		* Layer L + 1 from layer L, in the summation order of the scalar
+		* gemv kernel
+		********************************************************************/
+		template<std::size_t L>
+		void feedLayer(std::array<Real, NUM_NEURONS>& neurons) const
+		{
+			constexpr int in = TOPOLOGY[L], out = TOPOLOGY[L + 1];
+
+			Real* x = neurons.data() + NEURON_OFFSETS[L];
+			Real* y = neurons.data() + NEURON_OFFSETS[L + 1];
+			const Real* w = weights.data() + WEIGHT_OFFSETS[L];
+
+			//bias neuron
+			x[in] = -1;
+
+			//sums in a local array, so the compiler knows they do not alias the inputs
+			std::array<Real, out> sum = {};
+			for (int i = 0; i <= in; i++)
+			{
+				const Real xi = x[i];
+				for (int j = 0; j < out; j++) sum[j] += xi * w[i * out + j];
+			}
+			for (int j = 0; j < out; j++) y[j] = sum[j];
+
+			if (activations[L] == Activation::Sigmoid && activationMode == ActivationMode::Fast) kernels::sigmoidFast(y, out);
+			else kernels::activate(activations[L], y, out);
+		}
+
+	public:
+		//weights - one (TOPOLOGY[l] + 1) x TOPOLOGY[l + 1] matrix per layer, in checkpoint order
+		alignas(BUFFER_ALIGNMENT) std::array<Real, NUM_WEIGHTS> weights;
+
+	private:
+		std::array<Activation, NUM_WEIGHT_LAYERS> activations;
+		ActivationMode activationMode;
+	};
+
+	template<int... Layers>
+	using StaticNetwork = BasicStaticNetwork<double, Layers...>;
+
+	template<int... Layers>
+	using StaticNetworkF = BasicStaticNetwork<float, Layers...>;
+}
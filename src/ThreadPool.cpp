@@ -0,0 +1,92 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+using namespace air;
+
+ThreadPool::ThreadPool(int numThreads) : task(nullptr), numTasks(0), nextTask(0), busyWorkers(0), generation(0), stopping(false)
+{
+	if (numThreads <= 0) numThreads = hardwareThreads();
+
+	//the calling thread is the first worker
+	for (int i = 1; i < numThreads; i++) workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for (auto& w : workers) w.join();
+}
+
+/*******************************************************************
+* Number of hardware threads, at least 1
+********************************************************************/
+int ThreadPool::hardwareThreads()
+{
+	return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+/*******************************************************************
+* Runs task(0) ... task(nTasks - 1) across all threads and blocks
+* until every task has finished
+********************************************************************/
+void ThreadPool::run(int nTasks, const std::function<void(int)>& t)
+{
+	//nothing to share - run inline
+	if (workers.empty() || nTasks <= 1)
+	{
+		for (int i = 0; i < nTasks; i++) t(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = &t;
+		numTasks = nTasks;
+		nextTask = 0;
+		busyWorkers = (int)workers.size();
+		generation++;
+	}
+	wake.notify_all();
+
+	//help out, then wait for the workers to drain
+	runTasks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [this] { return busyWorkers == 0; });
+	task = nullptr;
+}
+
+/*******************************************************************
+* Takes tasks of the current run until none are left
+********************************************************************/
+void ThreadPool::runTasks()
+{
+	for (int i = nextTask++; i < numTasks; i = nextTask++) (*task)(i);
+}
+
+void ThreadPool::workerLoop()
+{
+	long seenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+			if (stopping) return;
+			seenGeneration = generation;
+		}
+
+		runTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busyWorkers == 0) done.notify_one();
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace air
+{
+	/*******************************************************************
+	* Fixed set of worker threads that run indexed tasks in parallel.
+	* The calling thread takes part in the work, so a pool of size 1
+	* runs everything inline without any synchronisation.
+	********************************************************************/
+	class ThreadPool
+	{
+	public:
+		//numThreads includes the calling thread, 0 = one per hardware thread
+		ThreadPool(int numThreads = 0);
+		~ThreadPool();
+
+		//number of threads working on a run (including the caller)
+		int size() const { return (int)workers.size() + 1; }
+
+		//calls task(i) for every i in [0, nTasks) and returns once all are done
+		void run(int nTasks, const std::function<void(int)>& task);
+
+		static int hardwareThreads();
+
+	private:
+		void workerLoop();
+		void runTasks();
+
+	private:
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable wake;			//signals workers a new run has started
+		std::condition_variable done;			//signals the caller all workers have finished
+
+		//current run
+		const std::function<void(int)>* task;
+		int numTasks;
+		std::atomic<int> nextTask;
+		int busyWorkers;
+		long generation;
+		bool stopping;
+	};
+}
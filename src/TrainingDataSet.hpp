@@ -1,19 +1,28 @@
 #pragma once
 #include <vector>
 #include <memory>
-#include "DataEntry.hpp"
+#include "DataStore.hpp"
 
 namespace air
 {
 	class TrainingDataSet
 	{
 	public:
-		std::vector<std::shared_ptr<DataEntry>> trainingSet;
-		std::vector<std::shared_ptr<DataEntry>> generalizationSet;
-		std::vector<std::shared_ptr<DataEntry>> validationSet;
+		std::shared_ptr<const DataStore> data;		//keeps the entries of the subsets alive
+		DataSubset trainingSet;
+		DataSubset generalizationSet;
+		DataSubset validationSet;
 
 		TrainingDataSet() {}
 
+		//point all subsets at a new store
+		void setData(std::shared_ptr<const DataStore> store)
+		{
+			clear();
+			data = store;
+			trainingSet.store = generalizationSet.store = validationSet.store = store.get();
+		}
+
 		void clear()
 		{
 			trainingSet.clear();
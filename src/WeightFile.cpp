@@ -0,0 +1,159 @@
+#include "WeightFile.hpp"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+using namespace air;
+
+namespace
+{
+	const char WEIGHT_FILE_MAGIC[4] = { 'A', 'I', 'R', 'W' };
+
+	//next multiple of the buffer alignment
+	std::uint64_t aligned(std::uint64_t offset)
+	{
+		return (offset + BUFFER_ALIGNMENT - 1) / BUFFER_ALIGNMENT * BUFFER_ALIGNMENT;
+	}
+
+	std::uint64_t fnv1a(const char* p, std::size_t n)
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			hash ^= (std::uint8_t)p[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+bool air::writeWeightFile(const std::string& filename, const std::vector<int>& topology, DataType type, const void* weights, std::size_t numWeights,
+	const std::vector<char>& state)
+{
+	WeightFileHeader header = {};
+	std::memcpy(header.magic, WEIGHT_FILE_MAGIC, sizeof(header.magic));
+	header.version = WEIGHT_FILE_VERSION;
+	header.dataType = (std::uint32_t)type;
+	header.numLayers = (std::uint32_t)topology.size();
+	header.numWeights = numWeights;
+	header.weightOffset = aligned(sizeof(header) + topology.size() * sizeof(std::uint32_t));
+	header.fileSize = header.weightOffset + numWeights * dataTypeSize(type);
+	if (!state.empty())
+	{
+		header.stateOffset = aligned(header.fileSize);
+		header.stateSize = state.size();
+		header.fileSize = header.stateOffset + header.stateSize;
+	}
+
+	//lay out the whole file in memory
+	std::vector<char> buffer(header.fileSize, 0);
+	for (int l = 0; l < (int)topology.size(); l++)
+	{
+		std::uint32_t n = (std::uint32_t)topology[l];
+		std::memcpy(buffer.data() + sizeof(header) + l * sizeof(n), &n, sizeof(n));
+	}
+	std::memcpy(buffer.data() + header.weightOffset, weights, numWeights * dataTypeSize(type));
+	if (!state.empty()) std::memcpy(buffer.data() + header.stateOffset, state.data(), state.size());
+
+	header.checksum = fnv1a(buffer.data() + sizeof(header), buffer.size() - sizeof(header));
+	std::memcpy(buffer.data(), &header, sizeof(header));
+
+	std::fstream outputFile;
+	outputFile.open(filename, std::ios::out | std::ios::binary);
+	if (!outputFile.is_open())
+	{
+		std::cout << std::endl << "Error - Weight output file '" << filename << "' could not be created: " << std::endl;
+		return false;
+	}
+
+	outputFile.write(buffer.data(), buffer.size());
+	bool success = outputFile.good();
+	outputFile.close();
+	return success;
+}
+
+bool air::readWeightFile(const std::string& filename, WeightFile& file)
+{
+	std::fstream inputFile;
+	inputFile.open(filename, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!inputFile.is_open())
+	{
+		std::cout << std::endl << "Error - Weight input file '" << filename << "' could not be opened: " << std::endl;
+		return false;
+	}
+
+	std::uint64_t size = (std::uint64_t)inputFile.tellg();
+	inputFile.seekg(0);
+	file.buffer.resize(size);
+	inputFile.read(file.buffer.data(), size);
+	inputFile.close();
+
+	WeightFileHeader& header = file.header;
+	if (size < sizeof(header) || std::memcmp(file.buffer.data(), WEIGHT_FILE_MAGIC, sizeof(WEIGHT_FILE_MAGIC)) != 0)
+	{
+		std::cout << std::endl << "Error - '" << filename << "' is not a weight file" << std::endl;
+		return false;
+	}
+
+	std::memcpy(&header, file.buffer.data(), sizeof(header));
+	if (header.version != WEIGHT_FILE_VERSION)
+	{
+		std::cout << std::endl << "Error - Unsupported weight file version: " << header.version << std::endl;
+		return false;
+	}
+	if (header.dataType != (std::uint32_t)DataType::Float64 && header.dataType != (std::uint32_t)DataType::Float32)
+	{
+		std::cout << std::endl << "Error - Unknown weight file element type: " << header.dataType << std::endl;
+		return false;
+	}
+	if (header.fileSize != size || header.weightOffset < sizeof(header) + header.numLayers * sizeof(std::uint32_t)
+		|| header.weightOffset + header.numWeights * dataTypeSize(file.dataType()) > size
+		|| (header.stateSize > 0 && (header.stateOffset < header.weightOffset || header.stateOffset + header.stateSize > size)))
+	{
+		std::cout << std::endl << "Error - Weight file '" << filename << "' is truncated" << std::endl;
+		return false;
+	}
+	if (fnv1a(file.buffer.data() + sizeof(header), size - sizeof(header)) != header.checksum)
+	{
+		std::cout << std::endl << "Error - Checksum mismatch in weight file '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	file.topology.resize(header.numLayers);
+	for (int l = 0; l < (int)header.numLayers; l++)
+	{
+		std::uint32_t n;
+		std::memcpy(&n, file.buffer.data() + sizeof(header) + l * sizeof(n), sizeof(n));
+		file.topology[l] = (int)n;
+	}
+
+	return true;
+}
+
+template<typename Real>
+void air::convertValues(const char* src, DataType type, std::size_t n, Real* dst)
+{
+	if (type == DataType::Float64 && sizeof(Real) == sizeof(double)) std::memcpy(dst, src, n * sizeof(double));
+	else if (type == DataType::Float32 && sizeof(Real) == sizeof(float)) std::memcpy(dst, src, n * sizeof(float));
+	else if (type == DataType::Float64)
+	{
+		for (std::size_t i = 0; i < n; i++)
+		{
+			double d;
+			std::memcpy(&d, src + i * sizeof(double), sizeof(double));
+			dst[i] = (Real)d;
+		}
+	}
+	else
+	{
+		for (std::size_t i = 0; i < n; i++)
+		{
+			float f;
+			std::memcpy(&f, src + i * sizeof(float), sizeof(float));
+			dst[i] = (Real)f;
+		}
+	}
+}
+
+template void air::convertValues<float>(const char*, DataType, std::size_t, float*);
+template void air::convertValues<double>(const char*, DataType, std::size_t, double*);
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "DataFile.hpp"
+
+/*******************************************************************
+* Binary weight checkpoint: a 64 byte header, the topology (one
+* uint32 per layer) and the weights in checkpoint order, starting on
+* a 64 byte boundary, optionally followed by an opaque block of
+* training state (also 64 byte aligned). Little-endian, the checksum
+* (64 bit FNV-1a) covers everything after the header.
+********************************************************************/
+namespace air
+{
+	const std::uint32_t WEIGHT_FILE_VERSION = 1;
+
+	struct WeightFileHeader
+	{
+		char magic[4];					//"AIRW"
+		std::uint32_t version;			//WEIGHT_FILE_VERSION
+		std::uint32_t dataType;			//DataType of the weights
+		std::uint32_t numLayers;		//neuron layers in the topology
+		std::uint64_t numWeights;
+		std::uint64_t weightOffset;		//from the start of the file
+		std::uint64_t fileSize;
+		std::uint64_t checksum;
+		std::uint64_t stateOffset;		//0 if the file holds no training state
+		std::uint64_t stateSize;
+	};
+	static_assert(sizeof(WeightFileHeader) == 64, "weight file header has to be 64 bytes");
+
+	//weight file contents read and checked with a single read
+	struct WeightFile
+	{
+		WeightFileHeader header;
+		std::vector<int> topology;
+		std::vector<char> buffer;		//whole file
+
+		DataType dataType() const { return (DataType)header.dataType; }
+		const char* weights() const { return buffer.data() + header.weightOffset; }
+		const char* state() const { return buffer.data() + header.stateOffset; }
+	};
+
+	//writes the whole checkpoint with a single write
+	bool writeWeightFile(const std::string& filename, const std::vector<int>& topology, DataType type, const void* weights, std::size_t numWeights,
+		const std::vector<char>& state = std::vector<char>());
+
+	//reads and verifies a checkpoint, prints why a file is rejected
+	bool readWeightFile(const std::string& filename, WeightFile& file);
+
+	//converts n values of the given element type
+	template<typename Real>
+	void convertValues(const char* src, DataType type, std::size_t n, Real* dst);
+}
@@ -0,0 +1,124 @@
+#include "WeightSnapshot.hpp"
+#include <iostream>
+#include <algorithm>
+
+using namespace air;
+
+template<typename Real>
+BasicSnapshotPublisher<Real>::BasicSnapshotPublisher(const Network& nn) : current(new Snapshot(nn, 1)), latestVersion(1), networkTopology(nn.topology), slots(nullptr)
+{
+
+}
+
+template<typename Real>
+BasicSnapshotPublisher<Real>::~BasicSnapshotPublisher()
+{
+	delete current.load();
+	for (const Snapshot* s : retired) delete s;
+
+	for (Slot* s = slots.load(); s != nullptr;)
+	{
+		Slot* next = s->next;
+		delete s;
+		s = next;
+	}
+}
+
+/*******************************************************************
+* Publish a copy of nn. The copy is made before the swap, readers
+* only ever see complete snapshots.
+********************************************************************/
+template<typename Real>
+long long BasicSnapshotPublisher<Real>::publish(const Network& nn)
+{
+	std::lock_guard<std::mutex> lock(publishMutex);
+
+	const Snapshot* previous = current.load();
+	if (nn.topology != networkTopology)
+	{
+		std::cout << std::endl << "Error - Snapshot topology does not match the published network" << std::endl;
+		return 0;
+	}
+
+	const Snapshot* snapshot = new Snapshot(nn, previous->version + 1);
+	current.store(snapshot);
+	latestVersion.store(snapshot->version);
+
+	retired.push_back(previous);
+	reclaim();
+
+	return snapshot->version;
+}
+
+/*******************************************************************
+* Delete the retired snapshots no reader has pinned. A reader pins
+* before checking that its snapshot is still the latest, so one that
+* missed this scan can only hold the current snapshot.
+********************************************************************/
+template<typename Real>
+void BasicSnapshotPublisher<Real>::reclaim()
+{
+	std::vector<const Snapshot*> pinned;
+	for (Slot* s = slots.load(); s != nullptr; s = s->next)
+	{
+		const Snapshot* p = s->pinned.load();
+		if (p != nullptr) pinned.push_back(p);
+	}
+
+	auto inUse = [&](const Snapshot* s) { return std::find(pinned.begin(), pinned.end(), s) != pinned.end(); };
+	auto end = std::partition(retired.begin(), retired.end(), inUse);
+
+	for (auto it = end; it != retired.end(); ++it) delete *it;
+	retired.erase(end, retired.end());
+}
+
+/*******************************************************************
+* Reuse a released slot or add a new one to the list
+********************************************************************/
+template<typename Real>
+typename BasicSnapshotPublisher<Real>::Slot* BasicSnapshotPublisher<Real>::claimSlot()
+{
+	for (Slot* s = slots.load(); s != nullptr; s = s->next)
+	{
+		bool free = false;
+		if (s->inUse.compare_exchange_strong(free, true)) return s;
+	}
+
+	Slot* slot = new Slot();
+	slot->next = slots.load();
+	while (!slots.compare_exchange_weak(slot->next, slot));
+
+	return slot;
+}
+
+template<typename Real>
+BasicSnapshotPublisher<Real>::Reader::Reader(BasicSnapshotPublisher& p) : publisher(p), slot(p.claimSlot())
+{
+
+}
+
+template<typename Real>
+BasicSnapshotPublisher<Real>::Reader::~Reader()
+{
+	release();
+	slot->inUse.store(false);
+}
+
+template<typename Real>
+const typename BasicSnapshotPublisher<Real>::Snapshot& BasicSnapshotPublisher<Real>::Reader::acquire()
+{
+	const Snapshot* snapshot = publisher.current.load();
+
+	//pin, then make sure the snapshot was not replaced (and maybe reclaimed) in between
+	while (true)
+	{
+		slot->pinned.store(snapshot);
+
+		const Snapshot* latest = publisher.current.load();
+		if (latest == snapshot) return *snapshot;
+		snapshot = latest;
+	}
+}
+
+template class air::BasicSnapshotPublisher<float>;
+template class air::BasicSnapshotPublisher<double>;
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "NeuralNetwork.hpp"
+
+namespace air
+{
+	/*******************************************************************
+	* Immutable copy of a network's weights, numbered in publishing
+	* order. Query it through the const inference API (with scratch).
+	********************************************************************/
+	template<typename Real>
+	class BasicWeightSnapshot
+	{
+	public:
+		BasicWeightSnapshot(const BasicNeuralNetwork<Real>& nn, long long v) : version(v), network(nn) {}
+
+		const long long version;
+		const BasicNeuralNetwork<Real> network;
+	};
+
+	/*******************************************************************
+	* Hands weight snapshots from a writer (the trainer) to any number
+	* of readers (game agents, inference engine threads), RCU style:
+	* publishing swaps one atomic pointer, readers pick up the latest
+	* snapshot without locks and keep using it until they acquire the
+	* next one. Every reader pins its snapshot in a hazard slot, a
+	* replaced snapshot is deleted once no slot points at it.
+	********************************************************************/
+	template<typename Real>
+	class BasicSnapshotPublisher
+	{
+	private:
+		struct Slot
+		{
+			std::atomic<const BasicWeightSnapshot<Real>*> pinned{ nullptr };
+			std::atomic<bool> inUse{ true };
+			Slot* next = nullptr;
+		};
+
+	public:
+		typedef BasicNeuralNetwork<Real> Network;
+		typedef BasicWeightSnapshot<Real> Snapshot;
+
+		/*******************************************************************
+		* Per thread access to the latest snapshot, a reader must not be
+		* shared between threads or outlive its publisher
+		********************************************************************/
+		class Reader
+		{
+		public:
+			Reader(BasicSnapshotPublisher& publisher);
+			~Reader();
+
+			Reader(const Reader&) = delete;
+			Reader& operator=(const Reader&) = delete;
+
+			//pins and returns the latest snapshot, valid until the next acquire or release
+			const Snapshot& acquire();
+
+			//unpins the current snapshot so it can be reclaimed
+			void release() { slot->pinned.store(nullptr); }
+
+		private:
+			BasicSnapshotPublisher& publisher;
+			Slot* slot;
+		};
+
+		//the first snapshot (version 1) is a copy of nn, later ones need its topology
+		BasicSnapshotPublisher(const Network& nn);
+		~BasicSnapshotPublisher();
+
+		BasicSnapshotPublisher(const BasicSnapshotPublisher&) = delete;
+		BasicSnapshotPublisher& operator=(const BasicSnapshotPublisher&) = delete;
+
+		//copies nn into a new snapshot and makes it the latest, returns its version (0 if the topology differs)
+		long long publish(const Network& nn);
+
+		//version of the latest snapshot
+		long long version() const { return latestVersion.load(); }
+
+		//topology of every snapshot, fixed by the first one
+		const std::vector<int>& topology() const { return networkTopology; }
+
+	private:
+		Slot* claimSlot();
+		void reclaim();
+
+	private:
+		//only dereferenced by the writer and through a pinned Reader, a replaced snapshot may be deleted at any time
+		std::atomic<const Snapshot*> current;
+		std::atomic<long long> latestVersion;
+		const std::vector<int> networkTopology;
+		std::atomic<Slot*> slots;						//every slot ever claimed, released slots are reused
+
+		//writer side
+		std::mutex publishMutex;
+		std::vector<const Snapshot*> retired;			//replaced snapshots some reader may still use
+	};
+
+	typedef BasicWeightSnapshot<double> WeightSnapshot;
+	typedef BasicWeightSnapshot<float> WeightSnapshotF;
+	typedef BasicSnapshotPublisher<double> SnapshotPublisher;
+	typedef BasicSnapshotPublisher<float> SnapshotPublisherF;
+}
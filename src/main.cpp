@@ -19,11 +19,12 @@ int main()
 
 	////create data set reader and load data file
 	DataReader d;
+	d.setSeed((unsigned int)time(0));
 	d.loadDataFile("../../src/data.csv", 16, 3);
 	d.setCreationApproach(STATIC, 10);
 
 	////create neural network
-	std::shared_ptr<NeuralNetwork> nn = std::make_shared<NeuralNetwork>(16, 20, 3, 3);
+	std::shared_ptr<NeuralNetwork> nn = std::make_shared<NeuralNetwork>(std::vector<int>{ 16, 20, 3 });
 
 	//create neural network trainer
 	NeuralNetworkTrainer nT(nn);
@@ -38,6 +39,9 @@ int main()
 	}
 
 	//save the weights
+	nn->saveCheckpoint("weights.airw");
+
+	//export the weights as text
 	nn->saveWeights("weights.csv");
 
     // run the program as long as the window is open